@@ -0,0 +1,195 @@
+#include "aggregates.h"
+
+Aggregates::Aggregates()
+{
+    Clear(millis());
+}
+
+void Aggregates::Clear(unsigned long now)
+{
+    memset(_fast, 0, sizeof(_fast));
+    memset(_slow, 0, sizeof(_slow));
+    clear(_fastOpen);
+    clear(_slowOpen);
+    _fastHead = 0;
+    _slowHead = 0;
+    _slowFolded = 0;
+    _start = now;
+}
+
+void Aggregates::clear(Accumulator &acc)
+{
+    for (uint8_t i = 0; i < AGG_CHANNELS; i++)
+    {
+        acc.min[i] = INT16_MAX;
+        acc.max[i] = INT16_MIN;
+        acc.sum[i] = 0;
+    }
+
+    acc.count = 0;
+}
+
+void Aggregates::close(const Accumulator &acc, Bucket &bucket)
+{
+    memset(&bucket, 0, sizeof(bucket));
+    bucket.count = acc.count;
+
+    if (acc.count == 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < AGG_CHANNELS; i++)
+    {
+        Range &range = bucket.range[i];
+        int32_t half = acc.sum[i] < 0 ? -(int32_t)(acc.count / 2) : acc.count / 2;
+
+        range.mean = (acc.sum[i] + half) / (int32_t)acc.count;
+
+        uint32_t below = (int32_t)range.mean - acc.min[i];
+        uint32_t above = (int32_t)acc.max[i] - range.mean;
+        uint32_t round = 0;
+
+        // rounded up, so the stored min and max never move inwards
+        while ((below + round) >> range.shift > AGG_RANGE_MAX || (above + round) >> range.shift > AGG_RANGE_MAX)
+        {
+            range.shift++;
+            round = (round << 1) | 1;
+        }
+
+        range.below = (below + round) >> range.shift;
+        range.above = (above + round) >> range.shift;
+    }
+}
+
+int16_t Aggregates::rangeMin(const Range &range)
+{
+    return max((int32_t)range.mean - ((int32_t)range.below << range.shift), (int32_t)INT16_MIN);
+}
+
+int16_t Aggregates::rangeMax(const Range &range)
+{
+    return min((int32_t)range.mean + ((int32_t)range.above << range.shift), (int32_t)INT16_MAX);
+}
+
+void Aggregates::fold(Accumulator &acc, const Bucket &bucket)
+{
+    if (bucket.count == 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < AGG_CHANNELS; i++)
+    {
+        const Range &range = bucket.range[i];
+
+        acc.min[i] = min(acc.min[i], rangeMin(range));
+        acc.max[i] = max(acc.max[i], rangeMax(range));
+        acc.sum[i] += (int32_t)range.mean * bucket.count;
+    }
+
+    acc.count += bucket.count;
+}
+
+void Aggregates::closeFast()
+{
+    Bucket &bucket = _fast[_fastHead];
+
+    close(_fastOpen, bucket);
+    fold(_slowOpen, bucket);
+    clear(_fastOpen);
+    _fastHead = (_fastHead + 1) % (AGG_FAST_BUCKETS - 1);
+
+    if (++_slowFolded == AGG_SLOW_SPAN)
+    {
+        close(_slowOpen, _slow[_slowHead]);
+        clear(_slowOpen);
+        _slowHead = (_slowHead + 1) % (AGG_SLOW_BUCKETS - 1);
+        _slowFolded = 0;
+    }
+}
+
+// differences are taken in 32 bits, so a host build wraps like the AVR
+void Aggregates::roll(unsigned long now)
+{
+    // nothing recent enough to keep, skip closing a day of empty buckets
+    if ((uint32_t)(now - _start) >= AGG_FAST_MS * AGG_SLOW_SPAN * AGG_SLOW_BUCKETS)
+    {
+        Clear(now);
+        return;
+    }
+
+    while ((uint32_t)(now - _start) >= AGG_FAST_MS)
+    {
+        closeFast();
+        _start += AGG_FAST_MS;
+    }
+}
+
+void Aggregates::Add(const int32_t *values, unsigned long now)
+{
+    roll(now);
+
+    for (uint8_t i = 0; i < AGG_CHANNELS; i++)
+    {
+        int16_t value = constrain(values[i], INT16_MIN, INT16_MAX);
+
+        _fastOpen.min[i] = min(_fastOpen.min[i], value);
+        _fastOpen.max[i] = max(_fastOpen.max[i], value);
+        _fastOpen.sum[i] += value;
+    }
+
+    _fastOpen.count++;
+}
+
+void Aggregates::merge(Stats &stats, int32_t &sum, int16_t min, int16_t max, int32_t bucketSum, uint16_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    stats.min = stats.count == 0 || min < stats.min ? min : stats.min;
+    stats.max = stats.count == 0 || max > stats.max ? max : stats.max;
+    stats.count += count;
+    sum += bucketSum;
+}
+
+// false when the window holds no samples
+bool Aggregates::Query(uint8_t window, uint8_t channel, unsigned long now, Stats &stats)
+{
+    int32_t sum = 0;
+
+    roll(now);
+    stats.count = 0;
+
+    merge(stats, sum, _fastOpen.min[channel], _fastOpen.max[channel], _fastOpen.sum[channel], _fastOpen.count);
+
+    if (window == AGG_HOUR)
+    {
+        for (uint8_t i = 0; i < AGG_FAST_BUCKETS - 1; i++)
+        {
+            const Range &range = _fast[i].range[channel];
+            merge(stats, sum, rangeMin(range), rangeMax(range), (int32_t)range.mean * _fast[i].count, _fast[i].count);
+        }
+    }
+    else
+    {
+        merge(stats, sum, _slowOpen.min[channel], _slowOpen.max[channel], _slowOpen.sum[channel], _slowOpen.count);
+
+        for (uint8_t i = 0; i < AGG_SLOW_BUCKETS - 1; i++)
+        {
+            const Range &range = _slow[i].range[channel];
+            merge(stats, sum, rangeMin(range), rangeMax(range), (int32_t)range.mean * _slow[i].count, _slow[i].count);
+        }
+    }
+
+    if (stats.count == 0)
+    {
+        return false;
+    }
+
+    int32_t half = sum < 0 ? -(int32_t)(stats.count / 2) : stats.count / 2;
+    stats.mean = (sum + half) / (int32_t)stats.count;
+    return true;
+}
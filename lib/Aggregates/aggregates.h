@@ -0,0 +1,95 @@
+#ifndef AGGREGATES
+#define AGGREGATES
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define AGG_CHANNELS 5
+#define AGG_FAST_MS 1800000UL // 30 min buckets
+#define AGG_FAST_BUCKETS 3    // 1 hr window, including the open bucket
+#define AGG_SLOW_SPAN 24      // fast buckets per slow bucket, 12 hrs
+#define AGG_SLOW_BUCKETS 3    // 24 hr window, including the open bucket
+#define AGG_RANGE_MAX 255     // widest stored min/max offset, see Range
+
+#define AGG_HOUR 0
+#define AGG_DAY 1
+
+// the closed buckets alone must span the nominal window
+#if (AGG_FAST_BUCKETS - 1) * AGG_FAST_MS < 3600000UL
+#error "the hour window would drop samples younger than an hour"
+#endif
+
+#if (AGG_SLOW_BUCKETS - 1) * AGG_SLOW_SPAN * AGG_FAST_MS < 86400000UL
+#error "the day window would drop samples younger than 24 hrs"
+#endif
+
+// Rolling min/max/mean in constant memory. Samples land in an open 30 min
+// bucket, closed buckets are kept for the hour window and folded into an
+// open 12 hr bucket, closed 12 hr buckets are kept for the day window. A
+// window is its open bucket plus the closed ones before it, so it covers
+// the last 60-90 min or 24-36 hrs. Bucket times are millis() differences,
+// rollover doesn't matter. A closed bucket is 27 bytes on AVR, the
+// bucket counts are what fits next to the SSD1306 framebuffer.
+class Aggregates
+{
+public:
+    struct Stats
+    {
+        int16_t min;
+        int16_t max;
+        int16_t mean;
+        uint16_t count;
+    };
+
+private:
+    // a closed bucket keeps min and max as offsets from the mean in steps
+    // of 2^shift, rounded outwards. Spans up to AGG_RANGE_MAX are exact.
+    struct Range
+    {
+        int16_t mean;
+        uint8_t below;
+        uint8_t above;
+        uint8_t shift;
+    };
+
+    struct Bucket
+    {
+        Range range[AGG_CHANNELS];
+        uint16_t count;
+    };
+
+    struct Accumulator
+    {
+        int16_t min[AGG_CHANNELS];
+        int16_t max[AGG_CHANNELS];
+        int32_t sum[AGG_CHANNELS];
+        uint16_t count;
+    };
+
+    Bucket _fast[AGG_FAST_BUCKETS - 1];
+    Bucket _slow[AGG_SLOW_BUCKETS - 1];
+    Accumulator _fastOpen;
+    Accumulator _slowOpen;
+    uint8_t _fastHead;
+    uint8_t _slowHead;
+    uint8_t _slowFolded;
+    unsigned long _start;
+
+    void roll(unsigned long now);
+    void closeFast();
+    static void clear(Accumulator &acc);
+    static void close(const Accumulator &acc, Bucket &bucket);
+    static void fold(Accumulator &acc, const Bucket &bucket);
+    static int16_t rangeMin(const Range &range);
+    static int16_t rangeMax(const Range &range);
+    static void merge(Stats &stats, int32_t &sum, int16_t min, int16_t max, int32_t bucketSum, uint16_t count);
+public:
+    Aggregates();
+    void Clear(unsigned long now);
+    void Add(const int32_t *values, unsigned long now);
+    bool Query(uint8_t window, uint8_t channel, unsigned long now, Stats &stats);
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "benchmark.h"
+#include "native_hal.h"
+#include "environment.h"
+#include "bme280_model.h"
+#include "ccs811_model.h"
+#include "ssd1306_model.h"
+#include <Adafruit_SSD1306.h>
+#include "DFRobot_BME280.h"
+#include "DFRobot_CCS811.h"
+#include "button.h"
+#include "text_buffer.h"
+
+#define BENCH_ITERATIONS 50
+#define BENCH_WARM_UP_MILLIS (21UL * 60000UL) // past MIN_TIME_FOR_CALIBRATION
+#define BENCH_MODES 7 // Temperature to BaselineAge, the button skips Calibrate
+
+// from src/main.cpp, main.h defines the globals and can't be included twice
+extern Adafruit_SSD1306 display;
+extern DFRobot_BME280_IIC bme;
+extern DFRobot_CCS811 CCS811;
+extern Button modeBtn;
+void updateSensorReading();
+void writeText(const TextBuffer &v);
+void formatSensorReading(TextBuffer &out, const __FlashStringHelper *heading, int32_t value, uint8_t scale, uint8_t decimals, const __FlashStringHelper *unit);
+void onPress();
+
+static const char *const modeNames[BENCH_MODES] = {"Temperature", "Pressure", "Humidity", "Altitude", "CO2", "VOC", "BaselineAge"};
+static StaticText<64> text;
+static uint32_t flip = 0;
+
+static void benchWriteText()
+{
+    // a changed reading every time, an unchanged one isn't redrawn
+    text.Assign(F("Temp: 72.3"));
+    text.print(flip++ & 1);
+    text.print(F("F"));
+    writeText(text);
+}
+
+// Adafruit_SSD1306 is the NativeHal fake, which sends the frame the way
+// the library does, so only the bus figures of this case mean anything
+static void benchDisplay()
+{
+    display.display();
+}
+
+static void benchButton()
+{
+    modeBtn.Update();
+}
+
+static void benchPressure()
+{
+    bme.getPressure();
+}
+
+static void benchHumidity()
+{
+    bme.getHumidity();
+}
+
+static void benchAltitude()
+{
+    bme.calAltitude(1015.0f, 98765 + (flip++ & 0xFF));
+}
+
+// the float pow() altitude calAltitudeFixed replaced, as a baseline for
+// it. libm isn't instrumented, only the host time of this case means much
+static float calAltitudePow(float seaLevelPressure, uint32_t pressure)
+{
+    return 44330 * (1.0f - pow(pressure / 100 / seaLevelPressure, 0.1903));
+}
+
+static void benchAltitudePow()
+{
+    volatile float altitude = calAltitudePow(1015.0f, 98765 + (flip++ & 0xFF));
+    (void)altitude;
+}
+
+static void benchAltitudeFixed()
+{
+    bme.calAltitudeFixed(101500UL, 98765 + (flip++ & 0xFF));
+}
+
+static void benchFormat()
+{
+    formatSensorReading(text, F("Temp"), 7230 + (flip++ & 0xFF), 2, 2, F("F"));
+}
+
+// the String and dtostrf readout formatSensorReading replaced, as a
+// baseline for it. String is counted like the device's core code, this
+// wrapper isn't, so the baseline reads one call low
+static String formatSensorReadingString(const char *heading, float v, String unit)
+{
+    String readout;
+    readout += heading;
+    readout += ": ";
+    readout += String(v);
+    readout += unit;
+
+    return readout;
+}
+
+static void benchFormatString()
+{
+    formatSensorReadingString("Temp", (7230 + (flip++ & 0xFF)) / 100.0f, "F");
+}
+
+static void benchSetInTempHum()
+{
+    CCS811.setInTempHum(22.5f, 45.0f);
+}
+
+static void usage()
+{
+    fputs("usage: program [--baseline FILE] [--threshold PERCENT] [--write FILE]\n"
+          "  --baseline   compare with FILE, exit 1 on a regression\n"
+          "  --threshold  allowed growth of a figure, default 5\n"
+          "  --write      save this run as the new baselines\n",
+          stderr);
+}
+
+// boots the firmware against the models in fixed air, warms it up, then
+// measures each hot path with the clock stopped
+int main(int argc, char **argv)
+{
+    const char *baselinePath = nullptr;
+    const char *writePath = nullptr;
+    float threshold = BENCH_THRESHOLD;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[++i] : nullptr;
+
+        if (value != nullptr && strcmp(argv[i - 1], "--baseline") == 0)
+        {
+            baselinePath = value;
+        }
+        else if (value != nullptr && strcmp(argv[i - 1], "--write") == 0)
+        {
+            writePath = value;
+        }
+        else if (value != nullptr && strcmp(argv[i - 1], "--threshold") == 0)
+        {
+            threshold = strtof(value, nullptr);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    StaticEnvironment air(22.5f, 45.0f, 98765.0f, 650.0f, 40.0f);
+    Bme280Model bmeModel(&air);
+    Ccs811Model ccsModel(&air, 2);
+    Ssd1306Model oled;
+    Benchmark bench;
+
+    Wire.Attach(0x76, &bmeModel);
+    Wire.Attach(0x5A, &ccsModel);
+    Wire.Attach(0x3C, &oled);
+    Native.Listen(&bmeModel);
+    Native.Listen(&ccsModel);
+    Native.SerialOutput(nullptr);
+
+    setup();
+
+    for (uint32_t ms = 0; ms < BENCH_WARM_UP_MILLIS; ms++)
+    {
+        loop();
+        Native.Advance(1000);
+    }
+
+    for (uint8_t m = 0; m < BENCH_MODES; m++)
+    {
+        char name[BENCH_NAME];
+
+        if (m > 0)
+        {
+            onPress();
+        }
+
+        snprintf(name, sizeof(name), "updateSensorReading/%s", modeNames[m]);
+        bench.Measure(name, updateSensorReading, BENCH_ITERATIONS);
+    }
+
+    bench.Measure("writeText", benchWriteText, BENCH_ITERATIONS);
+    bench.Measure("display.display (fake HAL)", benchDisplay, BENCH_ITERATIONS);
+    bench.Measure("Button::Update", benchButton, BENCH_ITERATIONS);
+    bench.Measure("DFRobot_BME280::getPressure", benchPressure, BENCH_ITERATIONS);
+    bench.Measure("DFRobot_BME280::getHumidity", benchHumidity, BENCH_ITERATIONS);
+    bench.Measure("DFRobot_BME280::calAltitude", benchAltitude, BENCH_ITERATIONS);
+    bench.Measure("DFRobot_BME280::calAltitudeFixed", benchAltitudeFixed, BENCH_ITERATIONS);
+    bench.Measure("DFRobot_BME280::calAltitude/pow", benchAltitudePow, BENCH_ITERATIONS);
+    bench.Measure("formatSensorReading", benchFormat, BENCH_ITERATIONS);
+    bench.Measure("formatSensorReading/String", benchFormatString, BENCH_ITERATIONS);
+    bench.Measure("DFRobot_CCS811::setInTempHum", benchSetInTempHum, BENCH_ITERATIONS);
+
+    bench.Print(stdout);
+
+    if (writePath != nullptr && !bench.Write(writePath))
+    {
+        fprintf(stderr, "bench: can't write %s\n", writePath);
+        return 2;
+    }
+
+    if (baselinePath == nullptr)
+    {
+        return 0;
+    }
+
+    int regressions = bench.Compare(baselinePath, threshold, stdout);
+
+    if (regressions < 0)
+    {
+        fprintf(stderr, "bench: can't read %s\n", baselinePath);
+        return 2;
+    }
+
+    printf("%d regression(s) past %.1f%%\n", regressions, threshold);
+    return regressions ? 1 : 0;
+}
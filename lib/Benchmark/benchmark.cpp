@@ -0,0 +1,185 @@
+#include <time.h>
+#include "benchmark.h"
+#include <Wire.h>
+
+static uint64_t calls = 0;
+
+// -finstrument-functions calls these around every instrumented function,
+// inlined ones included, so the count doesn't depend on the optimizer
+extern "C" __attribute__((no_instrument_function)) void __cyg_profile_func_enter(void *function, void *site)
+{
+    calls++;
+}
+
+extern "C" __attribute__((no_instrument_function)) void __cyg_profile_func_exit(void *function, void *site)
+{
+}
+
+static uint64_t hostNanos()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void Benchmark::Measure(const char *name, void (*body)(), uint16_t iterations)
+{
+    if (_count == BENCH_MAX_CASES || iterations == 0)
+    {
+        return;
+    }
+
+    // the baselines are plain CSV, such a name would never compare
+    if (strchr(name, ',') != nullptr)
+    {
+        fprintf(stderr, "bench: no commas in case names: %s\n", name);
+        return;
+    }
+
+    BenchResult &result = _results[_count++];
+    float fastest = 0;
+
+    strncpy(result.name, name, BENCH_NAME - 1);
+    result.name[BENCH_NAME - 1] = '\0';
+
+    for (uint8_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        WireStats before = Wire.Stats();
+        uint64_t callsBefore = calls;
+        uint64_t start = hostNanos();
+
+        for (uint16_t i = 0; i < iterations; i++)
+        {
+            body();
+        }
+
+        float nanos = (float)(hostNanos() - start) / iterations;
+        WireStats after = Wire.Stats();
+
+        // the counted figures come from the first round, later rounds only
+        // warm the host caches for the time
+        if (round == 0)
+        {
+            result.calls = (float)(calls - callsBefore) / iterations;
+            result.busBytes = (float)(after.bytesWritten + after.bytesRead + after.writes + after.reads - before.bytesWritten - before.bytesRead - before.writes - before.reads) / iterations;
+            result.busMicros = (float)(after.busNanos - before.busNanos) / 1000.0f / iterations;
+        }
+
+        if (round == 0 || nanos < fastest)
+        {
+            fastest = nanos;
+        }
+    }
+
+    result.hostNanos = fastest;
+}
+
+void Benchmark::Print(FILE *file)
+{
+    fprintf(file, "%-36s %10s %10s %10s %10s\n", "benchmark", "calls", "i2c_bytes", "bus_us", "host_ns");
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const BenchResult &r = _results[i];
+
+        fprintf(file, "%-36s %10.1f %10.1f %10.1f %10.0f\n", r.name, r.calls, r.busBytes, r.busMicros, r.hostNanos);
+    }
+}
+
+bool Benchmark::Write(const char *path)
+{
+    FILE *file = fopen(path, "w");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    fputs("name,calls,bus_bytes,bus_us\n", file);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const BenchResult &r = _results[i];
+
+        fprintf(file, "%s,%.1f,%.1f,%.1f\n", r.name, r.calls, r.busBytes, r.busMicros);
+    }
+
+    return fclose(file) == 0;
+}
+
+bool Benchmark::regressed(float now, float before, float threshold)
+{
+    return now - before > BENCH_SLACK && now > before * (1.0f + threshold / 100.0f);
+}
+
+// number of regressions past threshold percent, -1 when the baselines
+// can't be read. Cases missing from the file are reported, not failed.
+int Benchmark::Compare(const char *path, float threshold, FILE *file)
+{
+    FILE *baselines = fopen(path, "r");
+    BenchResult before[BENCH_MAX_CASES];
+    uint8_t count = 0;
+    char line[128];
+    int regressions = 0;
+
+    if (baselines == nullptr)
+    {
+        return -1;
+    }
+
+    while (count < BENCH_MAX_CASES && fgets(line, sizeof(line), baselines))
+    {
+        BenchResult &r = before[count];
+        char format[32];
+
+        snprintf(format, sizeof(format), "%%%d[^,],%%f,%%f,%%f", BENCH_NAME - 1);
+
+        if (sscanf(line, format, r.name, &r.calls, &r.busBytes, &r.busMicros) == 4)
+        {
+            count++;
+        }
+    }
+
+    fclose(baselines);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const BenchResult &now = _results[i];
+        const BenchResult *was = nullptr;
+
+        for (uint8_t j = 0; j < count; j++)
+        {
+            if (strcmp(before[j].name, now.name) == 0)
+            {
+                was = &before[j];
+                break;
+            }
+        }
+
+        if (was == nullptr)
+        {
+            fprintf(file, "new        %s\n", now.name);
+            continue;
+        }
+
+        const float values[] = {now.calls, now.busBytes, now.busMicros};
+        const float baseline[] = {was->calls, was->busBytes, was->busMicros};
+        static const char *const metrics[] = {"calls", "i2c_bytes", "bus_us"};
+
+        for (uint8_t m = 0; m < 3; m++)
+        {
+            if (regressed(values[m], baseline[m], threshold))
+            {
+                regressions++;
+                fprintf(file, "REGRESSED  %s %s %.1f -> %.1f\n", now.name, metrics[m], baseline[m], values[m]);
+            }
+            else if (regressed(baseline[m], values[m], threshold))
+            {
+                fprintf(file, "improved   %s %s %.1f -> %.1f, update the baselines\n", now.name, metrics[m], baseline[m], values[m]);
+            }
+        }
+    }
+
+    return regressions;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCHMARK
+#define BENCHMARK
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define BENCH_MAX_CASES 32
+#define BENCH_NAME 40
+#define BENCH_ROUNDS 5        // host time is the fastest round
+#define BENCH_SLACK 0.5f      // absolute change always tolerated, for tiny counts
+#define BENCH_THRESHOLD 5.0f  // percent
+
+// Per-call cost of a piece of firmware, averaged over the iterations.
+// calls, I2C bytes and bus time only depend on the code and the device
+// models, so they are what the baselines hold. Host time is printed as a
+// hint, it says little about the AVR.
+struct BenchResult
+{
+    char name[BENCH_NAME];
+    float calls;     // firmware function entries, needs -finstrument-functions
+    float busBytes;  // I2C bytes both ways, address bytes included
+    float busMicros; // at 100 kHz
+    float hostNanos;
+};
+
+// Runs benchmark bodies and checks them against a CSV of earlier results:
+//   name,calls,bus_bytes,bus_us
+// Names are written unquoted, so they can't contain commas.
+class Benchmark
+{
+private:
+    BenchResult _results[BENCH_MAX_CASES];
+    uint8_t _count = 0;
+
+    static bool regressed(float now, float before, float threshold);
+public:
+    void Measure(const char *name, void (*body)(), uint16_t iterations);
+    void Print(FILE *file);
+    bool Write(const char *path);
+    int Compare(const char *path, float threshold, FILE *file);
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "button.h"
 
+Button *Button::_interruptButton = nullptr;
+
 Button::Button(uint8_t pin)
 {
     _pin = pin;
@@ -16,87 +18,188 @@ void Button::OnLongPress(void(*callback)())
     _onLongPressCallback = callback;
 }
 
-long _lastNotifyTime;
+// with a double press callback set, short presses are reported once
+// DOUBLE_PRESS_GAP passed without a second press
+void Button::OnDoublePress(void(*callback)())
+{
+    _onDoublePressCallback = callback;
+}
+
+// only one button can own the interrupt, the pin needs to be INT0/INT1
+void Button::AttachInterrupt()
+{
+    _interruptButton = this;
+    _polling = false;
+    attachInterrupt(digitalPinToInterrupt(_pin), handleInterrupt, CHANGE);
+}
+
+void Button::handleInterrupt()
+{
+    Button *button = _interruptButton;
+    button->PushEdge(digitalRead(button->_pin), millis());
+}
+
+// for edges captured by someone else, Update() stops reading the pin
+void Button::DisablePolling()
+{
+    _polling = false;
+}
+
+// single producer, don't mix with AttachInterrupt()
+void Button::PushEdge(uint8_t level, unsigned long time)
+{
+    Edge edge;
+    edge.time = time;
+    edge.level = level;
+
+    // dropped when full, edges carry their level so the next one resyncs
+    _edges.Push(edge);
+}
 
 void Button::Update()
 {
-    unsigned long now = millis();
-    unsigned long timeDelta = now - _lastPressTime;
+    Edge edge;
 
-    /* if ((now - _lastNotifyTime) > 5000)
+    if (_polling)
     {
-        _lastNotifyTime = now;
-        DEBUG_MSG("Last");
-        DEBUG_MSG(_lastState);
-        DEBUG_MSG("Current");
-        DEBUG_MSG(_currentState);
-    } */
-    
-
-    if (_lastState == BTN_NOT_PRESSED && _currentState == BTN_NOT_PRESSED) {
-        if (isPressed() && timeDelta > DEBOUNCE) {
-            _lastState = _currentState;
-            _currentState = BTN_PRESSED;
-            _lastPressTime = now;
-            
-            //DEBUG_MSG("press start");
-        }
-    }
-    // BTN still pressed
-    else if (_lastState == BTN_NOT_PRESSED && _currentState == BTN_PRESSED) {
-        if (isPressed())
+        uint8_t level = isPressed() ? BTN_PRESSED : BTN_NOT_PRESSED;
+
+        if (level != _sampledLevel)
         {
-            if (timeDelta > 2000 && !_didLongPress)
-            {
-                //DEBUG_MSG("long press");
-                
-                if (_onLongPressCallback != nullptr) {
-                    (*_onLongPressCallback) ();
-                }
-
-                _didLongPress = true;
-            }            
-            
+            _sampledLevel = level;
+            PushEdge(level, millis());
         }
-        else {
-            if (timeDelta > DEBOUNCE && !_didShortPress && !_didLongPress) {
-                //DEBUG_MSG("short press");
+    }
 
-                if (_onPressCallback != nullptr) {
-                    (*_onPressCallback) ();
-                }
+    while (_edges.Pop(edge))
+    {
+        onEdge(edge);
+    }
 
-                _didShortPress = true;
-            }
+    // read after draining, an interrupt edge stamped later than an earlier
+    // now would make the unsigned differences in advance() wrap
+    advance(millis());
+}
+
+void Button::onEdge(const Edge &edge)
+{
+    advance(edge.time);
 
-            _lastState = _currentState;
-            _currentState = BTN_NOT_PRESSED;
-        }        
+    // a burst of bounces counts from its first edge
+    if (!_rawPending)
+    {
+        _rawStart = edge.time;
+        _rawPending = true;
     }
-    else if (_lastState == BTN_PRESSED && _currentState == BTN_NOT_PRESSED) {
-        if (isPressed())
+
+    _rawLevel = edge.level;
+    _rawTime = edge.time;
+}
+
+void Button::advance(unsigned long time)
+{
+    // the raw level is settled once it held for DEBOUNCE
+    if (_rawPending && time - _rawTime >= DEBOUNCE)
+    {
+        _rawPending = false;
+
+        if (_rawLevel != _level)
         {
-            if (timeDelta > 250 && !_didDoublePress) {
-                //DEBUG_MSG("double press");
-                _didDoublePress = true;
+            checkTimers(_rawStart);
+            _level = _rawLevel;
+
+            if (_level == BTN_PRESSED)
+            {
+                pressed(_rawStart);
+            }
+            else
+            {
+                released(_rawStart);
             }
-            
         }
-        else {
-            if (timeDelta > 500) {
-                _lastState = _currentState;
-                _currentState = BTN_NOT_PRESSED;
-                _didDoublePress = false;
-                _didLongPress = false;
-                _didShortPress = false;
-
-                //DEBUG_MSG("released");
+    }
+
+    // a change still settling may end the state at its first edge, so the
+    // timers can't run past that, however late this loop is
+    checkTimers(_rawPending ? _rawStart : time);
+}
+
+void Button::checkTimers(unsigned long time)
+{
+    if (_level == BTN_PRESSED)
+    {
+        if (!_didLongPress && time - _pressTime >= LONG_PRESS)
+        {
+            //DEBUG_MSG("long press");
+
+            // the first half of a would-be double press was a short press
+            if (_secondPress)
+            {
+                _secondPress = false;
+                notify(_onPressCallback);
             }
-        }  
+
+            _didLongPress = true;
+            notify(_onLongPressCallback);
+        }
+    }
+    else if (_pendingPress && time - _releaseTime > DOUBLE_PRESS_GAP)
+    {
+        //DEBUG_MSG("short press");
+        _pendingPress = false;
+        notify(_onPressCallback);
+    }
+}
+
+void Button::pressed(unsigned long time)
+{
+    //DEBUG_MSG("press start");
+    _pressTime = time;
+    _didLongPress = false;
+
+    if (_pendingPress)
+    {
+        _pendingPress = false;
+        _secondPress = true;
+    }
+}
+
+void Button::released(unsigned long time)
+{
+    //DEBUG_MSG("released");
+    _releaseTime = time;
+
+    if (_didLongPress)
+    {
+        return;
+    }
+
+    if (_secondPress)
+    {
+        //DEBUG_MSG("double press");
+        _secondPress = false;
+        notify(_onDoublePressCallback);
+    }
+    else if (_onDoublePressCallback != nullptr)
+    {
+        _pendingPress = true;
+    }
+    else
+    {
+        //DEBUG_MSG("short press");
+        notify(_onPressCallback);
+    }
+}
+
+void Button::notify(void(*callback)())
+{
+    if (callback != nullptr)
+    {
+        (*callback) ();
     }
 }
 
 bool Button::isPressed()
 {
     return digitalRead(_pin) == BTN_PRESSED;
-}
\ No newline at end of file
+}
@@ -6,9 +6,14 @@
 #include <Arduino.h>
 #endif
 
+#include "spsc_queue.h"
+
 #define BTN_PRESSED 0
 #define BTN_NOT_PRESSED 1
 #define DEBOUNCE 100
+#define LONG_PRESS 2000
+#define DOUBLE_PRESS_GAP 300 // max release to press time of a double press
+#define BTN_QUEUE_SIZE 8     // power of two
 
 /* #ifndef DEBUG
     #define DEBUG Serial.println
@@ -20,25 +25,57 @@
     #define DEBUG_MSG(msg)
 #endif */
 
+// Press detection works on timestamped edges. In interrupt mode the ISR
+// records them, when polling Update() records the level changes it sees.
+// Edges captured elsewhere can be handed in with PushEdge().
+// Classification only uses edge times, so a slow loop delays the callbacks
+// but never changes which one fires.
 class Button
 {
 private:
-    unsigned long _lastPressTime;
-    int _lastState = BTN_NOT_PRESSED;
-    int _currentState = BTN_NOT_PRESSED;
-    bool _didShortPress;
-    bool _didLongPress;
-    bool _didDoublePress;
+    struct Edge
+    {
+        unsigned long time;
+        uint8_t level;
+    };
+
+    SpscQueue<Edge, BTN_QUEUE_SIZE> _edges;
+    uint8_t _sampledLevel = BTN_NOT_PRESSED;
+    uint8_t _rawLevel = BTN_NOT_PRESSED;
+    unsigned long _rawStart;
+    unsigned long _rawTime;
+    bool _rawPending = false;
+    uint8_t _level = BTN_NOT_PRESSED;
+    unsigned long _pressTime;
+    unsigned long _releaseTime;
+    bool _didLongPress = false;
+    bool _pendingPress = false;
+    bool _secondPress = false;
+    bool _polling = true;
     uint8_t _pin;
     void(*_onPressCallback)() = nullptr;
     void(*_onLongPressCallback)() = nullptr;
+    void(*_onDoublePressCallback)() = nullptr;
+
+    static Button *_interruptButton;
+    static void handleInterrupt();
 
     bool isPressed();
+    void onEdge(const Edge &edge);
+    void advance(unsigned long time);
+    void checkTimers(unsigned long time);
+    void pressed(unsigned long time);
+    void released(unsigned long time);
+    void notify(void(*callback)());
 public:    
     Button(uint8_t pin);
     void OnPress(void(*callback)());
     void OnLongPress(void(*callback)());
+    void OnDoublePress(void(*callback)());
+    void AttachInterrupt();
+    void DisablePolling();
+    void PushEdge(uint8_t level, unsigned long time);
     void Update();
 };
 
-#endif
\ No newline at end of file
+#endif
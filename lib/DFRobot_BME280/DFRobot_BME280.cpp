@@ -24,7 +24,7 @@ const DFRobot_BME280::sRegs_t PROGMEM   _sRegs = DFRobot_BME280::sRegs_t();
 #ifdef __AVR__
 typedef uint16_t    platformBitWidth_t;
 #else
-typedef uint32_t    platformBitWidth_t;
+typedef uintptr_t   platformBitWidth_t;
 #endif
 
 const platformBitWidth_t    _regsAddr = (platformBitWidth_t) &_sRegs;
@@ -38,12 +38,59 @@ const platformBitWidth_t    _regsAddr = (platformBitWidth_t) &_sRegs;
 # define __DBG_CODE(x)
 #endif
 
+#define SAMPLE_TEMPERATURE    0x01
+#define SAMPLE_PRESSURE       0x02
+#define SAMPLE_HUMIDITY       0x04
+#define SAMPLE_ALL            (SAMPLE_TEMPERATURE | SAMPLE_PRESSURE | SAMPLE_HUMIDITY)
+
+// 44330 * (1 - r ^ 0.1903) for r = pressure / sea level pressure, sampled
+// every 1/256 of r from 0.25 to 1.25, in 20 cm units plus an offset so every
+// entry fits an uint16_t. Linear interpolation stays within 0.25 m.
+#define ALTITUDE_TABLE_OFFSET   9616
+#define ALTITUDE_TABLE_UNIT     20        // cm
+#define ALTITUDE_RATIO_MIN      8192      // 0.25 in Q15
+#define ALTITUDE_RATIO_MAX      40960     // 1.25 in Q15
+#define ALTITUDE_RATIO_EXTRA    9         // bits added to the Q15 ratio, Q24
+#define ALTITUDE_STEP_SHIFT     16        // 1/256 in Q24
+#define ALTITUDE_FRAC_BITS      13        // interpolation weight precision
+#define ALTITUDE_MAX_PA         0x1ffffUL // keeps pa << 15 inside 32 bits
+
+const uint16_t PROGMEM _altitudeTable[] = {
+  61013, 60510, 60013, 59522, 59037, 58558, 58084, 57616, 57153, 56696, 56243, 55796,
+  55353, 54915, 54481, 54052, 53627, 53207, 52791, 52378, 51970, 51566, 51166, 50769,
+  50376, 49987, 49601, 49218, 48839, 48464, 48091, 47722, 47356, 46993, 46633, 46276,
+  45922, 45570, 45222, 44876, 44533, 44193, 43855, 43520, 43187, 42857, 42529, 42204,
+  41881, 41560, 41242, 40926, 40612, 40300, 39991, 39683, 39378, 39075, 38773, 38474,
+  38177, 37882, 37588, 37296, 37007, 36719, 36433, 36148, 35866, 35585, 35306, 35028,
+  34753, 34478, 34206, 33935, 33666, 33398, 33131, 32867, 32603, 32342, 32081, 31822,
+  31565, 31309, 31054, 30801, 30549, 30298, 30049, 29801, 29554, 29309, 29065, 28822,
+  28580, 28340, 28100, 27862, 27625, 27390, 27155, 26922, 26689, 26458, 26228, 25999,
+  25771, 25544, 25319, 25094, 24870, 24648, 24426, 24205, 23986, 23767, 23549, 23333,
+  23117, 22902, 22688, 22475, 22263, 22052, 21842, 21633, 21424, 21217, 21010, 20804,
+  20599, 20395, 20192, 19989, 19788, 19587, 19387, 19188, 18989, 18792, 18595, 18399,
+  18203, 18009, 17815, 17622, 17430, 17238, 17047, 16857, 16668, 16479, 16291, 16104,
+  15917, 15731, 15546, 15361, 15177, 14994, 14812, 14630, 14448, 14268, 14088, 13908,
+  13730, 13551, 13374, 13197, 13021, 12845, 12670, 12495, 12322, 12148, 11976, 11803,
+  11632, 11461, 11290, 11120, 10951, 10782, 10614, 10446, 10279, 10113, 9947, 9781,
+  9616, 9451, 9288, 9124, 8961, 8799, 8637, 8475, 8314, 8154, 7994, 7834,
+  7675, 7517, 7359, 7201, 7044, 6887, 6731, 6576, 6420, 6265, 6111, 5957,
+  5804, 5651, 5498, 5346, 5194, 5043, 4892, 4742, 4592, 4442, 4293, 4144,
+  3996, 3848, 3701, 3554, 3407, 3261, 3115, 2969, 2824, 2679, 2535, 2391,
+  2248, 2104, 1962, 1819, 1677, 1535, 1394, 1253, 1113, 972, 833, 693,
+  554, 415, 277, 139, 1
+};
+
 uint8_t regOffset(const void *pReg)
 {
   return ((platformBitWidth_t) pReg - _regsAddr + BME280_REG_START);
 }
 
-DFRobot_BME280::DFRobot_BME280() {}
+DFRobot_BME280::DFRobot_BME280()
+{
+  memset(&_sSample, 0, sizeof(_sSample));
+  memset(&_sCalibPre, 0, sizeof(_sCalibPre));
+  _sampleUnread = 0;
+}
 
 DFRobot_BME280::eStatus_t DFRobot_BME280::begin()
 {
@@ -52,85 +99,135 @@ DFRobot_BME280::eStatus_t DFRobot_BME280::begin()
   __DBG_CODE(Serial.print("status register addr: "); Serial.print(regOffset(&_sRegs.status), HEX));
   __DBG_CODE(Serial.print("id register addr: "); Serial.print(regOffset(&_sRegs.chip_id), HEX));
 
+  eStatus_t   ret = beginStart();
+  if(ret != eStatusBusy)
+    return ret;
+  // start-up takes 2 ms, poll instead of a fixed delay but give up like the old 400 ms did
+  for(uint16_t waited = 0; waited < 400; waited += 2) {
+    delay(2);
+    if(beginPoll() == eStatusOK)
+      return eStatusOK;
+  }
+  lastOperateStatus = eStatusErrDeviceNotDetected;
+  return lastOperateStatus;
+}
+
+DFRobot_BME280::eStatus_t DFRobot_BME280::beginStart()
+{
   uint8_t   temp = getReg(regOffset(&_sRegs.chip_id));
   if((temp == BME280_REG_CHIP_ID_DEFAULT) && (lastOperateStatus == eStatusOK)) {
-    reset();
-    delay(300);
-    getCalibrate();
-    setCtrlMeasSamplingPress(eSampling_X8);
-    setCtrlMeasSamplingTemp(eSampling_X8);
-    setCtrlHumiSampling(eSampling_X8);
-    setConfigFilter(eConfigFilter_off);
-    setConfigTStandby(eConfigTStandby_125);
-    setCtrlMeasMode(eCtrlMeasMode_normal);    // set control measurement mode to make these settings effective
-  } else
-    lastOperateStatus = eStatusErrDeviceNotDetected;
+    temp = 0xb6;
+    writeReg(regOffset(&_sRegs.reset), (uint8_t*) &temp, sizeof(temp));
+    return eStatusBusy;
+  }
+  lastOperateStatus = eStatusErrDeviceNotDetected;
   return lastOperateStatus;
 }
 
-float DFRobot_BME280::getTemperature()
+DFRobot_BME280::eStatus_t DFRobot_BME280::beginPoll()
 {
-  int32_t   raw = getTemperatureRaw();
-  float     rslt = 0;
-  int32_t   v1, v2;
+  uint8_t   status = getReg(regOffset(&_sRegs.status));
+  if(lastOperateStatus != eStatusOK)
+    return lastOperateStatus;   // not answering yet right after the reset
+  if(status & 0x01)
+    return eStatusBusy;   // im_update, calibration data is still being copied
+  getCalibrate();
+  setCtrlMeasSamplingPress(eSampling_X8);
+  setCtrlMeasSamplingTemp(eSampling_X8);
+  setCtrlHumiSampling(eSampling_X8);
+  setConfigFilter(eConfigFilter_off);
+  setConfigTStandby(eConfigTStandby_125);
+  setCtrlMeasMode(eCtrlMeasMode_normal);    // set control measurement mode to make these settings effective
+  return lastOperateStatus;
+}
+
+const DFRobot_BME280::sSampleFixed_t& DFRobot_BME280::readSampleFixed()
+{
+  uint8_t   pBuf[8];    // press msb, lsb, xlsb, temp msb, lsb, xlsb, humi msb, lsb
+  memset(&_sSample, 0, sizeof(_sSample));
+  _sampleUnread = SAMPLE_ALL;
+  readReg(regOffset(&_sRegs.press), pBuf, sizeof(pBuf));
   if(lastOperateStatus == eStatusOK) {
-    v1 = ((((raw >> 3) - ((int32_t) _sCalib.t1 << 1))) * ((int32_t) _sCalib.t2)) >> 11;
-    v2 = (((((raw >> 4) - ((int32_t) _sCalib.t1)) * ((raw >> 4) - ((int32_t) _sCalib.t1))) >> 12) * ((int32_t) _sCalib.t3)) >> 14;
-    _t_fine = v1 + v2;
-    rslt = (_t_fine * 5 + 128) >> 8;
-    return (rslt / 100);
+    int32_t   rawPress = ((uint32_t) pBuf[0] << 12) | ((uint32_t) pBuf[1] << 4) | ((uint32_t) pBuf[2] >> 4);
+    int32_t   rawTemp = ((uint32_t) pBuf[3] << 12) | ((uint32_t) pBuf[4] << 4) | ((uint32_t) pBuf[5] >> 4);
+    int32_t   rawHumi = ((int32_t) pBuf[6] << 8) | (int32_t) pBuf[7];
+    __DBG_CODE(Serial.print("raw: "); Serial.print(rawHumi));
+    if(rawTemp == 0x80000) {
+      lastOperateStatus = eStatusBusy;   // no conversion since the reset
+      return _sSample;
+    }
+    _sSample.temperature = compensateTemperature(rawTemp);    // update _t_fine first
+#ifdef BME280_PRESSURE_INT32
+    _sSample.pressure = compensatePressure32(rawPress);
+#else
+    _sSample.pressure = compensatePressure(rawPress);
+#endif
+    _sSample.humidity = compensateHumidity(rawHumi);
   }
-  return 0;
+  return _sSample;
+}
+
+DFRobot_BME280::sSample_t DFRobot_BME280::readSample()
+{
+  const sSampleFixed_t   &sFixed = readSampleFixed();
+  sSample_t   sSample;
+  sSample.temperature = (float) sFixed.temperature / 100;
+  sSample.pressure = sFixed.pressure;
+  sSample.humidity = (float) sFixed.humidity / 1024.0f;
+  return sSample;
+}
+
+float DFRobot_BME280::getTemperature()
+{
+  return (float) takeSample(SAMPLE_TEMPERATURE).temperature / 100;
 }
 
 uint32_t DFRobot_BME280::getPressure()
 {
-  getTemperature();   // update _t_fine
-  int32_t   raw = getPressureRaw();
-  int64_t   rslt = 0;
-  int64_t   v1, v2;
-  if(lastOperateStatus == eStatusOK) {
-    v1 = ((int64_t) _t_fine) - 128000;
-    v2 = v1 * v1 * (int64_t) _sCalib.p6;
-    v2 = v2 + ((v1 * (int64_t) _sCalib.p5) << 17);
-    v2 = v2 + (((int64_t) _sCalib.p4) << 35);
-    v1 = ((v1 * v1 * (int64_t) _sCalib.p3) >> 8) + ((v1 * (int64_t) _sCalib.p2) << 12);
-    v1 = (((((int64_t) 1) << 47) + v1)) * ((int64_t) _sCalib.p1) >> 33;
-    if(v1 == 0)
-      return 0;
-    rslt = 1048576 - raw;
-    rslt = (((rslt << 31) - v2) * 3125) / v1;
-    v1 = (((int64_t) _sCalib.p9) * (rslt >> 13) * (rslt >> 13)) >> 25;
-    v2 = (((int64_t) _sCalib.p8) * rslt) >> 19;
-    rslt = ((rslt + v1 + v2) >> 8) + (((int64_t) _sCalib.p7) << 4);
-    return (uint32_t) (rslt / 256);
-  }
-  return 0;
+  return takeSample(SAMPLE_PRESSURE).pressure;
 }
 
 float DFRobot_BME280::getHumidity()
 {
-  getTemperature();   // update _t_fine
-  int32_t   raw = getHumidityRaw();
-  int32_t   v1;
-  __DBG_CODE(Serial.print("raw: "); Serial.print(raw));
-  if(lastOperateStatus == eStatusOK) {
-    v1 = (_t_fine - ((int32_t) 76800));
-    v1 = (((((raw <<14) - (((int32_t) _sCalibHumi.h4) << 20) - (((int32_t) _sCalibHumi.h5) * v1)) +
-         ((int32_t) 16384)) >> 15) * (((((((v1 * ((int32_t) _sCalibHumi.h6)) >> 10) * (((v1 *
-         ((int32_t) _sCalibHumi.h3)) >> 11) + ((int32_t) 32768))) >> 10) + ((int32_t) 2097152)) *
-         ((int32_t) _sCalibHumi.h2) + 8192) >> 14));
-    v1 = (v1 - (((((v1 >> 15) * (v1 >> 15)) >> 7) * ((int32_t) _sCalibHumi.h1)) >> 4));
-    v1 = (v1 < 0 ? 0 : v1);
-    v1 = (v1 > 419430400 ? 419430400 : v1);
-    return ((float) (v1 >> 12)) / 1024.0f;
-  }
-  return 0;
+  return (float) takeSample(SAMPLE_HUMIDITY).humidity / 1024.0f;
 }
 
 float DFRobot_BME280::calAltitude(float seaLevelPressure, uint32_t pressure)
 {
-  return 44330 * (1.0f - pow(pressure / 100 / seaLevelPressure, 0.1903));
+  return calAltitudeFixed((uint32_t) (seaLevelPressure * 100 + 0.5f), pressure) / 100.0f;
+}
+
+int32_t DFRobot_BME280::calAltitudeFixed(uint32_t seaLevelPressure, uint32_t pressure)
+{
+  uint32_t  ratio, rem, offset;
+  uint16_t  index, frac;
+  int32_t   h0, h1;
+  if(seaLevelPressure == 0)
+    return 0;
+  if(seaLevelPressure > ALTITUDE_MAX_PA)
+    seaLevelPressure = ALTITUDE_MAX_PA;
+  if(pressure > ALTITUDE_MAX_PA)
+    pressure = ALTITUDE_MAX_PA;
+
+  // ratio in Q24 from two 32 bit divisions, no int64
+  ratio = (pressure << 15) / seaLevelPressure;
+  rem = (pressure << 15) - ratio * seaLevelPressure;
+  if(ratio < ALTITUDE_RATIO_MIN) {
+    ratio = ALTITUDE_RATIO_MIN;
+    rem = 0;
+  } else if(ratio >= ALTITUDE_RATIO_MAX) {
+    ratio = ALTITUDE_RATIO_MAX - 1;
+    rem = seaLevelPressure - 1;
+  }
+  ratio = (ratio << ALTITUDE_RATIO_EXTRA) | ((rem << ALTITUDE_RATIO_EXTRA) / seaLevelPressure);
+
+  offset = ratio - ((uint32_t) ALTITUDE_RATIO_MIN << ALTITUDE_RATIO_EXTRA);
+  index = offset >> ALTITUDE_STEP_SHIFT;
+  frac = (offset & (((uint32_t) 1 << ALTITUDE_STEP_SHIFT) - 1)) >> (ALTITUDE_STEP_SHIFT - ALTITUDE_FRAC_BITS);
+  h0 = pgm_read_word(&_altitudeTable[index]);
+  h1 = pgm_read_word(&_altitudeTable[index + 1]);
+  return (h0 - ALTITUDE_TABLE_OFFSET) * ALTITUDE_TABLE_UNIT +
+         (((h1 - h0) * ALTITUDE_TABLE_UNIT * (int32_t) frac) >> ALTITUDE_FRAC_BITS);
 }
 
 void DFRobot_BME280::reset()
@@ -196,6 +293,86 @@ void DFRobot_BME280::getCalibrate()
   _sCalibHumi.h4 = ((_sCalibHumi.h4 >> 8) & 0x0f) | ((_sCalibHumi.h4 & 0x00ff) << 4);
   // 0xe5 [7: 4] / 0xe6 = dig_h5 [3: 0] / [11: 4]
   _sCalibHumi.h5 = ((_sCalibHumi.h5 & 0xff00) >> 4) | ((_sCalibHumi.h5 & 0x00f0) >> 4);   // fxxk fxxk fxxk very strange arrangement
+
+  // terms that only depend on calibration, kept out of every compensation
+  _sCalibPre.t1x2 = (int32_t) _sCalib.t1 << 1;
+  _sCalibPre.p4s35 = ((int64_t) _sCalib.p4) << 35;
+  _sCalibPre.p7s4 = ((int64_t) _sCalib.p7) << 4;
+  _sCalibPre.p4s16 = ((int32_t) _sCalib.p4) << 16;
+  _sCalibPre.h4s20 = ((int32_t) _sCalibHumi.h4) << 20;
+}
+
+int32_t DFRobot_BME280::compensateTemperature(int32_t raw)
+{
+  int32_t   v1, v2;
+  v1 = (((raw >> 3) - _sCalibPre.t1x2) * ((int32_t) _sCalib.t2)) >> 11;
+  v2 = (((((raw >> 4) - ((int32_t) _sCalib.t1)) * ((raw >> 4) - ((int32_t) _sCalib.t1))) >> 12) * ((int32_t) _sCalib.t3)) >> 14;
+  _t_fine = v1 + v2;
+  return (_t_fine * 5 + 128) >> 8;
+}
+
+uint32_t DFRobot_BME280::compensatePressure(int32_t raw)
+{
+  int64_t   rslt = 0;
+  int64_t   v1, v2;
+  v1 = ((int64_t) _t_fine) - 128000;
+  v2 = v1 * v1 * (int64_t) _sCalib.p6;
+  v2 = v2 + ((v1 * (int64_t) _sCalib.p5) << 17);
+  v2 = v2 + _sCalibPre.p4s35;
+  v1 = ((v1 * v1 * (int64_t) _sCalib.p3) >> 8) + ((v1 * (int64_t) _sCalib.p2) << 12);
+  v1 = (((((int64_t) 1) << 47) + v1)) * ((int64_t) _sCalib.p1) >> 33;
+  if(v1 == 0)
+    return 0;
+  rslt = 1048576 - raw;
+  rslt = (((rslt << 31) - v2) * 3125) / v1;
+  v1 = (((int64_t) _sCalib.p9) * (rslt >> 13) * (rslt >> 13)) >> 25;
+  v2 = (((int64_t) _sCalib.p8) * rslt) >> 19;
+  rslt = ((rslt + v1 + v2) >> 8) + _sCalibPre.p7s4;
+  return (uint32_t) (rslt / 256);
+}
+
+uint32_t DFRobot_BME280::compensatePressure32(int32_t raw)
+{
+  uint32_t  rslt;
+  int32_t   v1, v2;
+  v1 = (_t_fine >> 1) - (int32_t) 64000;
+  v2 = (((v1 >> 2) * (v1 >> 2)) >> 11) * ((int32_t) _sCalib.p6);
+  v2 = v2 + ((v1 * ((int32_t) _sCalib.p5)) << 1);
+  v2 = (v2 >> 2) + _sCalibPre.p4s16;
+  v1 = (((((int32_t) _sCalib.p3) * (((v1 >> 2) * (v1 >> 2)) >> 13)) >> 3) + ((((int32_t) _sCalib.p2) * v1) >> 1)) >> 18;
+  v1 = ((((int32_t) 32768 + v1)) * ((int32_t) _sCalib.p1)) >> 15;
+  if(v1 == 0)
+    return 0;
+  rslt = (((uint32_t) (((int32_t) 1048576) - raw) - (v2 >> 12))) * 3125;
+  if(rslt < 0x80000000)
+    rslt = (rslt << 1) / ((uint32_t) v1);
+  else
+    rslt = (rslt / (uint32_t) v1) * 2;
+  v1 = (((int32_t) _sCalib.p9) * ((int32_t) (((rslt >> 3) * (rslt >> 3)) >> 13))) >> 12;
+  v2 = (((int32_t) (rslt >> 2)) * ((int32_t) _sCalib.p8)) >> 13;
+  return (uint32_t) ((int32_t) rslt + ((v1 + v2 + _sCalib.p7) >> 4));
+}
+
+uint32_t DFRobot_BME280::compensateHumidity(int32_t raw)
+{
+  int32_t   v1;
+  v1 = (_t_fine - ((int32_t) 76800));
+  v1 = (((((raw <<14) - _sCalibPre.h4s20 - (((int32_t) _sCalibHumi.h5) * v1)) +
+       ((int32_t) 16384)) >> 15) * (((((((v1 * ((int32_t) _sCalibHumi.h6)) >> 10) * (((v1 *
+       ((int32_t) _sCalibHumi.h3)) >> 11) + ((int32_t) 32768))) >> 10) + ((int32_t) 2097152)) *
+       ((int32_t) _sCalibHumi.h2) + 8192) >> 14));
+  v1 = (v1 - (((((v1 >> 15) * (v1 >> 15)) >> 7) * ((int32_t) _sCalibHumi.h1)) >> 4));
+  v1 = (v1 < 0 ? 0 : v1);
+  v1 = (v1 > 419430400 ? 419430400 : v1);
+  return (uint32_t) (v1 >> 12);
+}
+
+const DFRobot_BME280::sSampleFixed_t& DFRobot_BME280::takeSample(uint8_t field)
+{
+  if(!(_sampleUnread & field))    // already handed out, fetch a new burst
+    readSampleFixed();
+  _sampleUnread &= ~field;
+  return _sSample;
 }
 
 int32_t DFRobot_BME280::getTemperatureRaw()
@@ -39,7 +39,8 @@ public:
     eStatusOK,
     eStatusErr,
     eStatusErrDeviceNotDetected,
-    eStatusErrParameter
+    eStatusErrParameter,
+    eStatusBusy
   } eStatus_t;
 
   typedef struct {
@@ -161,9 +162,35 @@ public:
     uint8_t   reserved3;
     sRegPress_t   press;
     sRegTemp_t    temp;
-    uint16_t    humi;
+    uint8_t   humi[2];    // msb, lsb, a uint16_t would be aligned to 0xfe on the host
   } sRegs_t;
 
+  /**
+   * @brief Compensated measurement set, read from 0xf7 ~ 0xfe in one burst
+   */
+  typedef struct {
+    float       temperature;    // Celsius
+    uint32_t    pressure;       // pa
+    float       humidity;       // percent
+  } sSample_t;
+
+  /**
+   * @brief Compensated measurement set in fixed point, as produced by the Bosch integer formulas
+   */
+  typedef struct {
+    int32_t     temperature;    // 0.01 Celsius
+    uint32_t    pressure;       // pa
+    uint32_t    humidity;       // percent in Q22.10, 47445 is 46.333 %
+  } sSampleFixed_t;
+
+  typedef struct {
+    int32_t   t1x2;     // t1 << 1
+    int64_t   p4s35;    // p4 << 35
+    int64_t   p7s4;     // p7 << 4
+    int32_t   p4s16;    // p4 << 16, 32 bit pressure variant
+    int32_t   h4s20;    // h4 << 20
+  } sCalibratePre_t;
+
 // functions
 public:
   DFRobot_BME280();
@@ -175,19 +202,45 @@ public:
   eStatus_t   begin();
 
   /**
-   * @brief getTemperature Get temperature
+   * @brief beginStart Non-blocking begin, check the chip id and issue a soft reset
+   * @return eStatusBusy when the reset was issued, poll beginPoll() from then on
+   */
+  eStatus_t   beginStart();
+
+  /**
+   * @brief beginPoll Finish begin once the sensor copied its NVM (status im_update cleared)
+   * @return eStatusOK when ready, eStatusBusy while still starting, otherwise the bus error
+   */
+  eStatus_t   beginPoll();
+
+  /**
+   * @brief readSampleFixed Burst read pressure, temperature and humidity, compensate temperature once
+   * @note Pressure uses the 64 bit formula, define BME280_PRESSURE_INT32 for the cheaper 32 bit one (+-1 pa)
+   * @return Cached sample, all zero when the bus read failed, or with lastOperateStatus
+   *         eStatusBusy while the registers still hold the reset value before the first conversion
+   */
+  const sSampleFixed_t&   readSampleFixed();
+
+  /**
+   * @brief readSample Burst read like readSampleFixed, converted to float
+   * @return Sample in Celsius, pa and percent
+   */
+  sSample_t   readSample();
+
+  /**
+   * @brief getTemperature Get temperature, served from the last sample until it was read once
    * @return Temprature in Celsius
    */
   float       getTemperature();
 
   /**
-   * @brief getPressure Get pressure
+   * @brief getPressure Get pressure, served from the last sample until it was read once
    * @return Pressure in pa
    */
   uint32_t    getPressure();
 
   /**
-   * @brief getHumidity Get humidity
+   * @brief getHumidity Get humidity, served from the last sample until it was read once
    * @return Humidity in percent
    */
   float       getHumidity();
@@ -200,6 +253,14 @@ public:
    */
   float       calAltitude(float seaLevelPressure, uint32_t pressure);
 
+  /**
+   * @brief calAltitudeFixed Calculate altitude from a table, no float or pow()
+   * @param seaLevelPressure Sea level pressure in pa
+   * @param pressure Pressure in pa
+   * @return Altitude in centimeter, within 0.5 m for pressure / seaLevelPressure in 0.25 ~ 1.25
+   */
+  int32_t     calAltitudeFixed(uint32_t seaLevelPressure, uint32_t pressure);
+
   /**
    * @brief reset Reset sensor
    */
@@ -248,6 +309,13 @@ protected:
   int32_t   getPressureRaw();
   int32_t   getHumidityRaw();
 
+  int32_t   compensateTemperature(int32_t raw);
+  uint32_t  compensatePressure(int32_t raw);
+  uint32_t  compensatePressure32(int32_t raw);
+  uint32_t  compensateHumidity(int32_t raw);
+
+  const sSampleFixed_t&   takeSample(uint8_t field);
+
   uint8_t   getReg(uint8_t reg);
   void      writeRegBits(uint8_t reg, uint8_t field, uint8_t val);
 
@@ -261,6 +329,10 @@ public:
 protected:
   int32_t   _t_fine;
 
+  sCalibratePre_t   _sCalibPre;
+  sSampleFixed_t    _sSample;
+  uint8_t     _sampleUnread;    // bit per sample field not yet returned by a getter
+
   sCalibrateDig_t   _sCalib;
   sCalibrateDigHumi_t   _sCalibHumi;
 };
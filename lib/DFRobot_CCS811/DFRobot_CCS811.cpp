@@ -14,21 +14,44 @@
 
 int DFRobot_CCS811::begin(void)
 {
-    uint8_t id=0;
+    int ret = beginStart();
+    // poll the boot instead of a fixed delay, within the old 100 ms
+    for(uint8_t waited = 0; (ret == ERR_BUSY || ret == ERR_DATA_BUS) && waited < 100; waited += 2){
+        delay(2);
+        ret = beginPoll();
+    }
+    return ret;
+}
+
+int DFRobot_CCS811::beginStart(void)
+{
     Wire.begin();
     softReset();
-    delay(100);
-    if(readReg(CCS811_REG_HW_ID,&id,1) != 1){DBG("");
-        DBG("bus data access error");DBG("");
-        return ERR_DATA_BUS;DBG("");
+    return ERR_BUSY;
+}
+
+int DFRobot_CCS811::beginPoll(void)
+{
+    uint8_t id=0;
+    uint8_t status=0;
+    if(readReg(CCS811_REG_HW_ID,&id,1) != 1 || readReg(CCS811_REG_STATUS,&status,1) != 1){
+        DBG("bus data access error");
+        return ERR_DATA_BUS;
     }
 
     DBG("real sensor id=");DBG(id);
-    if(id != CCS811_HW_ID){DBG("");
-        delay(1);
+    if(id != CCS811_HW_ID){
         return ERR_IC_VERSION;
     }
-    writeReg(CCS811_BOOTLOADER_APP_START, NULL, 0);
+    // FW_MODE, still in the boot loader
+    if(!(status & 0x80)){
+        // APP_VALID, nothing to start
+        if(!(status & 0x10)){
+            return ERR_IC_VERSION;
+        }
+        writeReg(CCS811_BOOTLOADER_APP_START, NULL, 0);
+        return ERR_BUSY;
+    }
     setMeasurementMode(eCycle_250ms,0,0);
     setInTempHum(25, 50);
     return ERR_OK;
@@ -76,31 +99,46 @@ uint8_t DFRobot_CCS811::getMeasurementMode(){
     return meas[0];
 }
 
-void DFRobot_CCS811::setThresholds(uint16_t lowToMed, uint16_t medToHigh)
+void DFRobot_CCS811::setThresholds(uint16_t lowToMed, uint16_t medToHigh, uint8_t hysteresis)
 {
-    uint8_t buffer[] = {(uint8_t)((lowToMed >> 8) & 0xF),
-                        (uint8_t)(lowToMed & 0xF),
-                        (uint8_t)((medToHigh >> 8) & 0xF),
-                        (uint8_t)(medToHigh & 0xF)};
+    uint8_t buffer[] = {(uint8_t)(lowToMed >> 8),
+                        (uint8_t)lowToMed,
+                        (uint8_t)(medToHigh >> 8),
+                        (uint8_t)medToHigh,
+                        hysteresis};
     
-    writeReg(CCS811_REG_THRESHOLDS, buffer, 5);
-    uint8_t buf[1];
-    readReg(CCS811_REG_THRESHOLDS, buf, 1);
-    Serial.println(buf[0],HEX);
+    writeReg(CCS811_REG_THRESHOLDS, buffer, sizeof(buffer));
+}
+
+DFRobot_CCS811::sResult_t DFRobot_CCS811::readResult()
+{
+    uint8_t buffer[8] = {0};
+    sResult_t result;
+    memset(&result, 0, sizeof(result));
+    if(readReg(CCS811_REG_ALG_RESULT_DATA, buffer, 8) != 8){
+        DBG("bus data access error");
+        return result;
+    }
+    result.eCO2 = (((uint16_t)buffer[0] << 8) | (uint16_t)buffer[1]);
+    result.eTVOC = (((uint16_t)buffer[2] << 8) | (uint16_t)buffer[3]);
+    result.status = buffer[4];
+    result.errorId = buffer[5];
+    result.rawData = (((uint16_t)buffer[6] << 8) | (uint16_t)buffer[7]);
+    result.current = result.rawData >> 10;
+    result.voltage = result.rawData & 0x3FF;
+    result.dataReady = (result.status >> 3) & 0x01;
+    DBG(result.status,HEX);
+    eCO2 = result.eCO2;
+    eTVOC = result.eTVOC;
+    return result;
 }
 
 uint16_t DFRobot_CCS811::getCO2PPM(){
-    uint8_t buffer[8];
-    readReg(CCS811_REG_ALG_RESULT_DATA, buffer, 8);
-    eCO2 = (((uint16_t)buffer[0] << 8) | (uint16_t)buffer[1]);
-    return eCO2;
+    return readResult().eCO2;
 }
 
 uint16_t DFRobot_CCS811::getTVOCPPB(){
-    uint8_t buffer[8];
-    readReg(CCS811_REG_ALG_RESULT_DATA, buffer, 8);
-    eTVOC = (((uint16_t)buffer[2] << 8) | (uint16_t)buffer[3]);
-    return eTVOC;
+    return readResult().eTVOC;
 }
 
 void DFRobot_CCS811::setInTempHum(float temperature, float humidity)    // compensate for temperature and relative humidity
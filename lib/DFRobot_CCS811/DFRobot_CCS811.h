@@ -62,6 +62,7 @@ public:
     #define ERR_OK             0      //OK 
     #define ERR_DATA_BUS      -1      //error in data bus
     #define ERR_IC_VERSION    -2      //chip version mismatch
+    #define ERR_BUSY          -3      //still starting, call beginPoll() again
     
     uint8_t _deviceAddr;
     
@@ -72,6 +73,20 @@ public:
         eCycle_60s,   //Low power pulse heating mode IAQ measurement every 60 seconds
         eCycle_250ms  //Constant power mode, sensor measurement every 250ms 1xx: Reserved modes (For future use)
     }eCycle_t;
+
+    /**
+     * @brief One decoded ALG_RESULT_DATA frame
+     */
+    typedef struct{
+        uint16_t eCO2;        //carbon dioxide concentration, unit: ppm
+        uint16_t eTVOC;       //TVOC concentration, unit: ppb
+        uint8_t  status;      //STATUS register at the time of the read
+        uint8_t  errorId;     //ERROR_ID register, valid if the ERROR bit of status is set
+        uint16_t rawData;     //RAW_DATA register
+        uint8_t  current;     //sensor current, unit: uA (RAW_DATA[15:10])
+        uint16_t voltage;     //sensor voltage, 1.65V / 1023 per LSB (RAW_DATA[9:0])
+        bool     dataReady;   //DATA_READY bit of status, false as well if the bus read failed
+    }sResult_t;
     /**
      * @brief Constructor 
      * @param Input in Wire address
@@ -83,11 +98,26 @@ public:
                * @return Return 0 if initialization succeeds, otherwise return non-zero.
                */
     int       begin();
+              /**
+               * @brief Non-blocking begin, issue a soft reset
+               * @return ERR_BUSY, poll beginPoll() from then on
+               */
+    int       beginStart();
+              /**
+               * @brief Finish begin, start the application firmware once the boot loader is up and configure it
+               * @return ERR_OK when ready, ERR_BUSY while starting, ERR_DATA_BUS while not answering, ERR_IC_VERSION
+               */
+    int       beginPoll();
               /**
                * @brief Judge if there is data to read 
                * @return Return 1 if there is, otherwise return 0. 
                */
     bool      checkDataReady();
+              /**
+               * @brief Read eCO2, TVOC, STATUS, ERROR_ID and RAW_DATA in one 8-byte transaction
+               * @return Decoded frame, data ready is taken from the STATUS byte of the same frame
+               */
+    sResult_t readResult();
               /**
                * @brief Reset sensor, clear all configured data.
                */
@@ -112,11 +142,12 @@ public:
                */
               setMeasurementMode(eCycle_t mode, uint8_t thresh = 0, uint8_t interrupt = 0),
               /**
-               * @brief Set interrupt thresholds 
+               * @brief Set interrupt thresholds, used when setMeasurementMode() enabled thresh and interrupt
                * @param lowToMed: interrupt triggered value in range low to middle 
                * @param medToHigh: interrupt triggered value in range middle to high 
+               * @param hysteresis: eCO2 has to cross a threshold by more than this (ppm) before nINT is asserted
                */
-              setThresholds(uint16_t lowToMed, uint16_t medToHigh);
+              setThresholds(uint16_t lowToMed, uint16_t medToHigh, uint8_t hysteresis = 50);
               /**
                * @brief Get current configured parameter
                * @return configuration code, needs to be converted into binary code to analyze
@@ -0,0 +1,424 @@
+#include "bme280_model.h"
+
+#define REG_CALIB 0x88
+#define REG_H1 0xA1
+#define REG_CHIP_ID 0xD0
+#define REG_RESET 0xE0
+#define REG_H2 0xE1
+#define REG_H3 0xE3
+#define REG_H4 0xE4
+#define REG_H45 0xE5
+#define REG_H5 0xE6
+#define REG_H6 0xE7
+#define REG_CTRL_HUM 0xF2
+#define REG_STATUS 0xF3
+#define REG_CTRL_MEAS 0xF4
+#define REG_CONFIG 0xF5
+#define REG_PRESS 0xF7
+#define REG_TEMP 0xFA
+#define REG_HUM 0xFD
+
+#define MODE_SLEEP 0
+#define MODE_NORMAL 3
+
+// dig_T1..dig_P9 of the datasheet's example part, little endian from 0x88
+static const int32_t calibration[] = {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+static const uint8_t digH1 = 75;
+static const int16_t digH2 = 362;
+static const uint8_t digH3 = 0;
+static const int16_t digH4 = 313;
+static const int16_t digH5 = 50;
+static const int8_t digH6 = 30;
+
+static const uint32_t standbyTable[] = {500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000};
+
+static uint8_t oversampling(uint8_t setting)
+{
+    return setting == 0 ? 0 : 1 << (min(setting, 5) - 1);
+}
+
+Bme280Model::Bme280Model(EnvironmentSource *source)
+{
+    _source = source;
+    memset(_regs, 0, sizeof(_regs));
+
+    for (uint8_t i = 0; i < sizeof(calibration) / sizeof(calibration[0]); i++)
+    {
+        _regs[REG_CALIB + i * 2] = (uint8_t)calibration[i];
+        _regs[REG_CALIB + i * 2 + 1] = (uint8_t)(calibration[i] >> 8);
+    }
+
+    _regs[REG_H1] = digH1;
+    _regs[REG_H2] = (uint8_t)digH2;
+    _regs[REG_H2 + 1] = (uint8_t)(digH2 >> 8);
+    _regs[REG_H3] = digH3;
+    _regs[REG_H4] = (uint8_t)(digH4 >> 4);
+    _regs[REG_H45] = (uint8_t)((digH4 & 0x0F) | ((digH5 & 0x0F) << 4));
+    _regs[REG_H5] = (uint8_t)(digH5 >> 4);
+    _regs[REG_H6] = (uint8_t)digH6;
+    _regs[REG_CHIP_ID] = BME280_MODEL_CHIP_ID;
+
+    _now = Native.Micros();
+    reset();
+}
+
+uint16_t Bme280Model::calU16(uint8_t reg)
+{
+    return _regs[reg] | (_regs[reg + 1] << 8);
+}
+
+int16_t Bme280Model::calS16(uint8_t reg)
+{
+    return (int16_t)calU16(reg);
+}
+
+// datasheet 4.2.3, 0.01 C
+int32_t Bme280Model::compensateT(int32_t adc, int32_t *tFine)
+{
+    int32_t t1 = calU16(REG_CALIB);
+    int32_t t2 = calS16(REG_CALIB + 2);
+    int32_t t3 = calS16(REG_CALIB + 4);
+    int32_t var1 = ((((adc >> 3) - (t1 << 1))) * t2) >> 11;
+    int32_t var2 = (((((adc >> 4) - t1) * ((adc >> 4) - t1)) >> 12) * t3) >> 14;
+
+    *tFine = var1 + var2;
+    return (*tFine * 5 + 128) >> 8;
+}
+
+// datasheet 4.2.3, Pa in Q24.8
+uint32_t Bme280Model::compensateP(int32_t adc, int32_t tFine)
+{
+    int64_t p1 = calU16(REG_CALIB + 6);
+    int64_t p2 = calS16(REG_CALIB + 8);
+    int64_t p3 = calS16(REG_CALIB + 10);
+    int64_t p4 = calS16(REG_CALIB + 12);
+    int64_t p5 = calS16(REG_CALIB + 14);
+    int64_t p6 = calS16(REG_CALIB + 16);
+    int64_t p7 = calS16(REG_CALIB + 18);
+    int64_t p8 = calS16(REG_CALIB + 20);
+    int64_t p9 = calS16(REG_CALIB + 22);
+    int64_t var1 = (int64_t)tFine - 128000;
+    int64_t var2 = var1 * var1 * p6;
+    int64_t p;
+
+    var2 = var2 + ((var1 * p5) << 17);
+    var2 = var2 + (p4 << 35);
+    var1 = ((var1 * var1 * p3) >> 8) + ((var1 * p2) << 12);
+    var1 = ((((int64_t)1) << 47) + var1) * p1 >> 33;
+
+    if (var1 == 0)
+    {
+        return 0;
+    }
+
+    p = 1048576 - adc;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (p9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (p8 * p) >> 19;
+    return (uint32_t)(((p + var1 + var2) >> 8) + (p7 << 4));
+}
+
+// datasheet 4.2.3, %RH in Q22.10
+uint32_t Bme280Model::compensateH(int32_t adc, int32_t tFine)
+{
+    int32_t h4 = ((int8_t)_regs[REG_H4] << 4) | (_regs[REG_H45] & 0x0F);
+    int32_t h5 = ((int8_t)_regs[REG_H5] << 4) | (_regs[REG_H45] >> 4);
+    int32_t v = tFine - 76800;
+
+    v = (((((adc << 14) - (h4 << 20) - (h5 * v)) + 16384) >> 15) *
+         (((((((v * (int8_t)_regs[REG_H6]) >> 10) * (((v * (int32_t)_regs[REG_H3]) >> 11) + 32768)) >> 10) + 2097152) *
+               calS16(REG_H2) +
+           8192) >>
+          14));
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * (int32_t)_regs[REG_H1]) >> 4);
+    v = v < 0 ? 0 : v;
+    v = v > 419430400 ? 419430400 : v;
+    return (uint32_t)(v >> 12);
+}
+
+// the compensations are monotonic, so a binary search inverts them
+uint32_t Bme280Model::rawTemperature(float celsius, int32_t *tFine)
+{
+    int32_t target = lroundf(celsius * 100.0f);
+    uint32_t lo = 0;
+    uint32_t hi = 0xFFFFF;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (compensateT(mid, tFine) < target)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    compensateT(lo, tFine);
+    return lo;
+}
+
+uint32_t Bme280Model::rawPressure(float pascal, int32_t tFine)
+{
+    uint32_t target = (uint32_t)lroundf(pascal * 256.0f);
+    uint32_t lo = 0;
+    uint32_t hi = 0xFFFFF;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (compensateP(mid, tFine) > target)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+uint16_t Bme280Model::rawHumidity(float percent, int32_t tFine)
+{
+    uint32_t target = (uint32_t)lroundf(constrain(percent, 0.0f, 100.0f) * 1024.0f);
+    uint32_t lo = 0;
+    uint32_t hi = 0xFFFF;
+
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+
+        if (compensateH(mid, tFine) < target)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// power-on state, the calibration NVM is copied again meanwhile
+void Bme280Model::reset()
+{
+    _regs[REG_CTRL_HUM] = 0;
+    _regs[REG_CTRL_MEAS] = 0;
+    _regs[REG_CONFIG] = 0;
+    _regs[REG_PRESS] = 0x80;
+    _regs[REG_PRESS + 1] = 0;
+    _regs[REG_PRESS + 2] = 0;
+    _regs[REG_TEMP] = 0x80;
+    _regs[REG_TEMP + 1] = 0;
+    _regs[REG_TEMP + 2] = 0;
+    _regs[REG_HUM] = 0x80;
+    _regs[REG_HUM + 1] = 0;
+    _ctrlHum = 0;
+    _measuring = false;
+    _filterPrimed = false;
+    _nvmUntil = _now + BME280_MODEL_NVM_MICROS;
+}
+
+void Bme280Model::writeReg(uint8_t reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case REG_RESET:
+        if (value == BME280_MODEL_RESET_WORD)
+        {
+            reset();
+        }
+        break;
+    case REG_CTRL_HUM:
+        _regs[reg] = value & 0x07;
+        break;
+    case REG_CTRL_MEAS:
+        // ctrl_hum only takes effect with a ctrl_meas write
+        _regs[reg] = value;
+        _ctrlHum = _regs[REG_CTRL_HUM];
+
+        if ((value & 0x03) == MODE_SLEEP)
+        {
+            _measuring = false;
+        }
+        else if (!_measuring || (value & 0x03) != MODE_NORMAL)
+        {
+            startMeasurement(_now);
+        }
+        break;
+    case REG_CONFIG:
+        _regs[reg] = value & 0xFD;
+        break;
+    default:
+        // read-only or reserved
+        break;
+    }
+}
+
+uint8_t Bme280Model::readReg(uint8_t reg)
+{
+    if (reg == REG_STATUS)
+    {
+        bool converting = _measuring && _now >= _measureStart;
+
+        return (converting ? 0x08 : 0) | (_now < _nvmUntil ? 0x01 : 0);
+    }
+
+    return reg == REG_RESET ? 0 : _regs[reg];
+}
+
+// datasheet 9.1, maximum times
+uint64_t Bme280Model::measureMicros()
+{
+    uint8_t t = oversampling(_regs[REG_CTRL_MEAS] >> 5);
+    uint8_t p = oversampling((_regs[REG_CTRL_MEAS] >> 2) & 0x07);
+    uint8_t h = oversampling(_ctrlHum);
+
+    return 1250 + 2300 * t + (p ? 2300 * p + 575 : 0) + (h ? 2300 * h + 575 : 0);
+}
+
+uint64_t Bme280Model::standbyMicros()
+{
+    return standbyTable[_regs[REG_CONFIG] >> 5];
+}
+
+void Bme280Model::startMeasurement(uint64_t at)
+{
+    _measureStart = at;
+    _measureEnd = at + measureMicros();
+    _measuring = true;
+}
+
+void Bme280Model::finishMeasurement()
+{
+    Environment air;
+    uint8_t osT = _regs[REG_CTRL_MEAS] >> 5;
+    uint8_t osP = (_regs[REG_CTRL_MEAS] >> 2) & 0x07;
+    uint8_t filter = (_regs[REG_CONFIG] >> 2) & 0x07;
+    uint32_t coefficient = filter == 0 ? 1 : 1 << min(filter, 4);
+    int32_t tFine;
+
+    _source->Sample(_measureEnd, air);
+
+    uint32_t adcT = rawTemperature(air.temperature, &tFine);
+    uint32_t adcP = rawPressure(air.pressure, tFine);
+    uint16_t adcH = rawHumidity(air.humidity, tFine);
+
+    // IIR filter on T and P, the first sample after a reset seeds it
+    if (!_filterPrimed)
+    {
+        _filteredT = adcT;
+        _filteredP = adcP;
+        _filterPrimed = true;
+    }
+
+    _filteredT = (_filteredT * (coefficient - 1) + adcT) / coefficient;
+    _filteredP = (_filteredP * (coefficient - 1) + adcP) / coefficient;
+
+    // 16 bit plus one per oversampling step, the filter always gives 20
+    uint32_t maskT = filter ? 0xFFFFF : 0xFFFFF & ~((1UL << (5 - min(osT, 5))) - 1);
+    uint32_t maskP = filter ? 0xFFFFF : 0xFFFFF & ~((1UL << (5 - min(osP, 5))) - 1);
+    uint32_t outT = osT ? _filteredT & maskT : BME280_MODEL_SKIPPED;
+    uint32_t outP = osP ? _filteredP & maskP : BME280_MODEL_SKIPPED;
+    uint16_t outH = _ctrlHum ? adcH : 0x8000;
+
+    _regs[REG_PRESS] = outP >> 12;
+    _regs[REG_PRESS + 1] = outP >> 4;
+    _regs[REG_PRESS + 2] = (outP & 0x0F) << 4;
+    _regs[REG_TEMP] = outT >> 12;
+    _regs[REG_TEMP + 1] = outT >> 4;
+    _regs[REG_TEMP + 2] = (outT & 0x0F) << 4;
+    _regs[REG_HUM] = outH >> 8;
+    _regs[REG_HUM + 1] = outH;
+    _measurements++;
+
+    if ((_regs[REG_CTRL_MEAS] & 0x03) == MODE_NORMAL)
+    {
+        startMeasurement(_measureEnd + standbyMicros());
+    }
+    else
+    {
+        // forced mode falls back to sleep
+        _regs[REG_CTRL_MEAS] &= ~0x03;
+        _measuring = false;
+    }
+}
+
+void Bme280Model::update(uint64_t now)
+{
+    _now = now;
+
+    if (_measuring && (_regs[REG_CTRL_MEAS] & 0x03) == MODE_NORMAL && _measureEnd <= now)
+    {
+        // skip what the filter has long forgotten after a big jump in time
+        uint64_t period = measureMicros() + standbyMicros();
+        uint64_t cycles = (now - _measureEnd) / period;
+
+        if (cycles > BME280_MODEL_MAX_CATCH_UP)
+        {
+            _measureStart += (cycles - BME280_MODEL_MAX_CATCH_UP) * period;
+            _measureEnd += (cycles - BME280_MODEL_MAX_CATCH_UP) * period;
+        }
+    }
+
+    while (_measuring && _measureEnd <= now)
+    {
+        finishMeasurement();
+    }
+}
+
+// register address, then register/value pairs, as in datasheet 6.2.1
+void Bme280Model::Receive(const uint8_t *data, uint8_t length)
+{
+    update(Native.Micros());
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    uint8_t reg = data[0];
+
+    _pointer = reg;
+
+    for (uint8_t i = 1; i < length; i += 2)
+    {
+        writeReg(reg, data[i]);
+
+        if (i + 1 < length)
+        {
+            reg = data[i + 1];
+        }
+    }
+}
+
+// burst reads auto-increment the register address
+uint8_t Bme280Model::Request(uint8_t *data, uint8_t length)
+{
+    update(Native.Micros());
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        data[i] = readReg(_pointer++);
+    }
+
+    return length;
+}
+
+void Bme280Model::Tick(uint64_t micros)
+{
+    update(micros);
+}
+
+uint32_t Bme280Model::Measurements()
+{
+    return _measurements;
+}
@@ -0,0 +1,69 @@
+#ifndef BME280_MODEL
+#define BME280_MODEL
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#include <Wire.h>
+#include "native_hal.h"
+#include "environment.h"
+
+#define BME280_MODEL_CHIP_ID 0x60
+#define BME280_MODEL_RESET_WORD 0xB6
+#define BME280_MODEL_NVM_MICROS 2000 // im_update after power-on and soft reset
+#define BME280_MODEL_SKIPPED 0x80000 // T/P output of a skipped measurement
+#define BME280_MODEL_MAX_CATCH_UP 64 // normal mode cycles replayed after a long gap
+
+// BME280 register file on the fake bus.
+// Holds the calibration block at 0x88-0xA1/0xE1-0xE7 (the datasheet's
+// example part), chip-id, soft reset with im_update, ctrl_hum latched by
+// the next ctrl_meas write, sleep/forced/normal modes timed from the
+// oversampling and t_sb settings, the IIR filter and the burst data
+// registers at 0xF7-0xFE. Raw ADC values are found by inverting the
+// datasheet compensation, so the driver reads back what the
+// EnvironmentSource says to within the register resolution.
+class Bme280Model : public WireDevice, public ClockListener
+{
+private:
+    EnvironmentSource *_source;
+    uint8_t _regs[256];
+    uint8_t _pointer = 0;
+    uint8_t _ctrlHum = 0;        // latched osrs_h
+    uint64_t _now = 0;
+    uint64_t _nvmUntil = 0;
+    uint64_t _measureStart = 0;
+    uint64_t _measureEnd = 0;
+    bool _measuring = false;
+    bool _filterPrimed = false;
+    uint32_t _filteredT;
+    uint32_t _filteredP;
+    uint32_t _measurements = 0;
+
+    uint16_t calU16(uint8_t reg);
+    int16_t calS16(uint8_t reg);
+    int32_t compensateT(int32_t adc, int32_t *tFine);
+    uint32_t compensateP(int32_t adc, int32_t tFine);
+    uint32_t compensateH(int32_t adc, int32_t tFine);
+    uint32_t rawTemperature(float celsius, int32_t *tFine);
+    uint32_t rawPressure(float pascal, int32_t tFine);
+    uint16_t rawHumidity(float percent, int32_t tFine);
+
+    void reset();
+    void writeReg(uint8_t reg, uint8_t value);
+    uint8_t readReg(uint8_t reg);
+    uint64_t measureMicros();
+    uint64_t standbyMicros();
+    void startMeasurement(uint64_t at);
+    void finishMeasurement();
+    void update(uint64_t now);
+public:
+    Bme280Model(EnvironmentSource *source);
+    void Receive(const uint8_t *data, uint8_t length);
+    uint8_t Request(uint8_t *data, uint8_t length);
+    void Tick(uint64_t micros);
+    uint32_t Measurements();
+};
+
+#endif
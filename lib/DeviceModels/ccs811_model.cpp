@@ -0,0 +1,375 @@
+#include "ccs811_model.h"
+
+#define REG_STATUS 0x00
+#define REG_MEAS_MODE 0x01
+#define REG_ALG_RESULT_DATA 0x02
+#define REG_RAW_DATA 0x03
+#define REG_ENV_DATA 0x05
+#define REG_THRESHOLDS 0x10
+#define REG_BASELINE 0x11
+#define REG_HW_ID 0x20
+#define REG_HW_VERSION 0x21
+#define REG_FW_BOOT_VERSION 0x23
+#define REG_FW_APP_VERSION 0x24
+#define REG_ERROR_ID 0xE0
+#define REG_APP_START 0xF4
+#define REG_SW_RESET 0xFF
+
+#define STATUS_ERROR 0x01
+#define STATUS_DATA_READY 0x08
+#define STATUS_APP_VALID 0x10
+#define STATUS_FW_MODE 0x80
+
+#define ERROR_WRITE_REG_INVALID 0x01
+#define ERROR_READ_REG_INVALID 0x02
+#define ERROR_MEASMODE_INVALID 0x04
+
+#define MEAS_INT_THRESH 0x04
+#define MEAS_INT_DATARDY 0x08
+#define DRIVE_MODE_RAW 4
+
+#define ECO2_MIN 400
+#define ECO2_MAX 32768
+#define TVOC_MAX 32768
+#define RAW_CURRENT 20 // uA, the auto-selected heater current
+
+static const uint8_t resetSequence[] = {0x11, 0xE5, 0x72, 0x8A};
+static const uint32_t frameMillis[] = {0, 1000, 10000, 60000, 250};
+
+Ccs811Model::Ccs811Model(EnvironmentSource *source, int8_t intPin)
+{
+    _source = source;
+    _intPin = intPin;
+    _now = Native.Micros();
+    reset();
+}
+
+void Ccs811Model::reset()
+{
+    _appMode = false;
+    _appStarting = false;
+    _measMode = 0;
+    _status = 0;
+    _errorId = 0;
+    _baselineOffset = CCS811_MODEL_COLD_OFFSET;
+    _eCO2 = 0;
+    _tvoc = 0;
+    _raw = 0;
+    _env[0] = 50 << 1; // 50 %RH, 25 C
+    _env[1] = 0;
+    _env[2] = (25 + 25) << 1;
+    _env[3] = 0;
+    _lowToMed = 1500;
+    _medToHigh = 2500;
+    _hysteresis = 50;
+    _band = 0;
+    setInterrupt(false);
+}
+
+void Ccs811Model::fail(uint8_t error)
+{
+    _errorId |= error;
+    _status |= STATUS_ERROR;
+}
+
+uint64_t Ccs811Model::framePeriod()
+{
+    uint8_t drive = (_measMode >> 4) & 0x07;
+
+    return drive <= DRIVE_MODE_RAW ? frameMillis[drive] * 1000ULL : 0;
+}
+
+// the eCO2 range, moving out of one takes a step past the hysteresis
+uint8_t Ccs811Model::band(uint16_t eCO2)
+{
+    int32_t value = eCO2;
+    uint8_t up = value > (int32_t)_medToHigh + _hysteresis ? 2 : (value > (int32_t)_lowToMed + _hysteresis ? 1 : 0);
+    uint8_t down = value < (int32_t)_lowToMed - _hysteresis ? 0 : (value < (int32_t)_medToHigh - _hysteresis ? 1 : 2);
+
+    if (up > _band)
+    {
+        return up;
+    }
+
+    return down < _band ? down : _band;
+}
+
+// nINT is open drain, released it reads high through the pull-up
+void Ccs811Model::setInterrupt(bool asserted)
+{
+    if (_intPin >= 0 && asserted != _interrupt)
+    {
+        Native.SetPin(_intPin, asserted ? LOW : HIGH);
+    }
+
+    _interrupt = asserted;
+}
+
+void Ccs811Model::frame(uint64_t at)
+{
+    Environment air;
+    uint64_t period = framePeriod();
+
+    _source->Sample(at, air);
+
+    // RAW_DATA only mode leaves the algorithm and its results alone
+    if (((_measMode >> 4) & 0x07) != DRIVE_MODE_RAW)
+    {
+        _baselineOffset *= expf(-(float)period / 1e6f / CCS811_MODEL_SETTLE_SECONDS);
+
+        float offset = _baselineOffset * CCS811_MODEL_PPM_PER_COUNT;
+
+        _eCO2 = constrain(lroundf(air.eCO2 + offset), ECO2_MIN, ECO2_MAX);
+        _tvoc = constrain(lroundf(air.tvoc + offset * 0.3f), 0, TVOC_MAX);
+    }
+
+    uint16_t voltage = constrain(lroundf(600.0f - air.tvoc / 4.0f + _baselineOffset / 16.0f), 0, 1023);
+
+    _raw = (RAW_CURRENT << 10) | voltage;
+    _status |= STATUS_DATA_READY;
+    _frames++;
+
+    uint8_t next = band(_eCO2);
+    bool changed = next != _band;
+
+    _band = next;
+
+    if ((_measMode & MEAS_INT_DATARDY) && (!(_measMode & MEAS_INT_THRESH) || changed))
+    {
+        setInterrupt(true);
+    }
+}
+
+void Ccs811Model::writeMailbox(uint8_t reg, const uint8_t *data, uint8_t length)
+{
+    if (reg == REG_SW_RESET)
+    {
+        if (length == sizeof(resetSequence) && memcmp(data, resetSequence, length) == 0)
+        {
+            reset();
+        }
+        return;
+    }
+
+    if (reg == REG_APP_START && length == 0 && !_appMode)
+    {
+        _appStarting = true;
+        _appAt = _now + CCS811_MODEL_START_MICROS;
+        return;
+    }
+
+    // a bare address write only selects the mailbox to read
+    if (length == 0)
+    {
+        return;
+    }
+
+    if (!_appMode)
+    {
+        fail(ERROR_WRITE_REG_INVALID);
+        return;
+    }
+
+    switch (reg)
+    {
+    case REG_MEAS_MODE:
+        if (((data[0] >> 4) & 0x07) > DRIVE_MODE_RAW)
+        {
+            fail(ERROR_MEASMODE_INVALID);
+            break;
+        }
+
+        _measMode = data[0] & 0x7C;
+        _nextFrame = _now + framePeriod();
+
+        if (!(_measMode & MEAS_INT_DATARDY))
+        {
+            setInterrupt(false);
+        }
+        break;
+    case REG_ENV_DATA:
+        if (length >= sizeof(_env))
+        {
+            memcpy(_env, data, sizeof(_env));
+            _envWrites++;
+        }
+        break;
+    case REG_THRESHOLDS:
+        if (length >= 5)
+        {
+            _lowToMed = (data[0] << 8) | data[1];
+            _medToHigh = (data[2] << 8) | data[3];
+            _hysteresis = data[4];
+        }
+        break;
+    case REG_BASELINE:
+        if (length >= 2)
+        {
+            _baselineOffset = (float)(((data[0] << 8) | data[1]) - CCS811_MODEL_BASELINE);
+        }
+        break;
+    default:
+        fail(ERROR_WRITE_REG_INVALID);
+        break;
+    }
+}
+
+void Ccs811Model::update(uint64_t now)
+{
+    _now = now;
+
+    if (_appStarting && now >= _appAt)
+    {
+        _appStarting = false;
+        _appMode = true;
+    }
+
+    uint64_t period = framePeriod();
+
+    if (!_appMode || period == 0)
+    {
+        return;
+    }
+
+    if (_nextFrame <= now)
+    {
+        // only the baseline remembers frames skipped after a big jump in time
+        uint64_t frames = (now - _nextFrame) / period;
+
+        if (frames > CCS811_MODEL_MAX_CATCH_UP)
+        {
+            uint64_t skipped = frames - CCS811_MODEL_MAX_CATCH_UP;
+
+            if (((_measMode >> 4) & 0x07) != DRIVE_MODE_RAW)
+            {
+                _baselineOffset *= expf(-(float)(skipped * period) / 1e6f / CCS811_MODEL_SETTLE_SECONDS);
+            }
+
+            _nextFrame += skipped * period;
+        }
+    }
+
+    while (_nextFrame <= now)
+    {
+        frame(_nextFrame);
+        _nextFrame += period;
+    }
+}
+
+void Ccs811Model::Receive(const uint8_t *data, uint8_t length)
+{
+    update(Native.Micros());
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    _pointer = data[0];
+    writeMailbox(data[0], data + 1, length - 1);
+}
+
+uint8_t Ccs811Model::Request(uint8_t *data, uint8_t length)
+{
+    uint8_t mailbox[8];
+    uint8_t size = 0;
+    bool appOnly = true;
+
+    update(Native.Micros());
+
+    switch (_pointer)
+    {
+    case REG_STATUS:
+        mailbox[size++] = (_appMode ? STATUS_FW_MODE : 0) | STATUS_APP_VALID | (_status & (STATUS_ERROR | STATUS_DATA_READY));
+        appOnly = false;
+        break;
+    case REG_MEAS_MODE:
+        mailbox[size++] = _measMode;
+        break;
+    case REG_ALG_RESULT_DATA:
+        mailbox[size++] = _eCO2 >> 8;
+        mailbox[size++] = _eCO2;
+        mailbox[size++] = _tvoc >> 8;
+        mailbox[size++] = _tvoc;
+        mailbox[size++] = (_appMode ? STATUS_FW_MODE : 0) | STATUS_APP_VALID | (_status & (STATUS_ERROR | STATUS_DATA_READY));
+        mailbox[size++] = _errorId;
+        mailbox[size++] = _raw >> 8;
+        mailbox[size++] = _raw;
+        break;
+    case REG_RAW_DATA:
+        mailbox[size++] = _raw >> 8;
+        mailbox[size++] = _raw;
+        break;
+    case REG_BASELINE:
+        mailbox[size++] = Baseline() >> 8;
+        mailbox[size++] = Baseline();
+        break;
+    case REG_HW_ID:
+        mailbox[size++] = CCS811_MODEL_HW_ID;
+        appOnly = false;
+        break;
+    case REG_HW_VERSION:
+        mailbox[size++] = CCS811_MODEL_HW_VERSION;
+        appOnly = false;
+        break;
+    case REG_FW_BOOT_VERSION:
+        mailbox[size++] = 0x10;
+        mailbox[size++] = 0x00;
+        appOnly = false;
+        break;
+    case REG_FW_APP_VERSION:
+        mailbox[size++] = 0x20;
+        mailbox[size++] = 0x00;
+        appOnly = false;
+        break;
+    case REG_ERROR_ID:
+        mailbox[size++] = _errorId;
+        _errorId = 0;
+        _status &= ~STATUS_ERROR;
+        appOnly = false;
+        break;
+    default:
+        fail(ERROR_READ_REG_INVALID);
+        break;
+    }
+
+    if (appOnly && !_appMode)
+    {
+        size = 0;
+        fail(ERROR_READ_REG_INVALID);
+    }
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        data[i] = i < size ? mailbox[i] : 0;
+    }
+
+    // reading the results clears DATA_READY and releases nINT
+    if (_pointer == REG_ALG_RESULT_DATA && size > 0)
+    {
+        _status &= ~STATUS_DATA_READY;
+        setInterrupt(false);
+    }
+
+    return length;
+}
+
+void Ccs811Model::Tick(uint64_t micros)
+{
+    update(micros);
+}
+
+uint16_t Ccs811Model::Baseline()
+{
+    return constrain(lroundf(CCS811_MODEL_BASELINE + _baselineOffset), 0, 0xFFFF);
+}
+
+uint32_t Ccs811Model::Frames()
+{
+    return _frames;
+}
+
+uint32_t Ccs811Model::EnvWrites()
+{
+    return _envWrites;
+}
@@ -0,0 +1,78 @@
+#ifndef CCS811_MODEL
+#define CCS811_MODEL
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#include <Wire.h>
+#include "native_hal.h"
+#include "environment.h"
+
+#define CCS811_MODEL_HW_ID 0x81
+#define CCS811_MODEL_HW_VERSION 0x12
+#define CCS811_MODEL_BOOT_MICROS 2000 // after power-on and SW_RESET
+#define CCS811_MODEL_START_MICROS 1000 // APP_START to FW_MODE
+#define CCS811_MODEL_BASELINE 0x847B   // what a settled part reports in this air
+#define CCS811_MODEL_COLD_OFFSET 1200  // baseline counts off after power-on
+#define CCS811_MODEL_PPM_PER_COUNT 0.5f
+#define CCS811_MODEL_SETTLE_SECONDS 180.0f // baseline time constant while measuring
+#define CCS811_MODEL_MAX_CATCH_UP 64  // frames replayed after a long gap
+
+// CCS811 mailboxes on the fake bus: STATUS, MEAS_MODE, ALG_RESULT_DATA,
+// RAW_DATA, ENV_DATA, THRESHOLDS, BASELINE, HW_ID/versions, ERROR_ID,
+// APP_START and SW_RESET, with boot and application mode and the error
+// codes for invalid accesses. nINT is driven on the given pin for
+// data-ready and threshold interrupts and released by an ALG_RESULT_DATA
+// read.
+// The algorithm is reduced to its baseline: it starts CCS811_MODEL_COLD_OFFSET
+// counts off after power-on and decays towards the settled value while
+// measuring, and every count off adds to eCO2/TVOC and the raw voltage.
+// Writing a saved baseline therefore skips the warm-up, as on the part.
+class Ccs811Model : public WireDevice, public ClockListener
+{
+private:
+    EnvironmentSource *_source;
+    int8_t _intPin;
+    uint8_t _pointer = 0;
+    uint64_t _now = 0;
+    uint64_t _appAt = 0;
+    bool _appMode = false;
+    bool _appStarting = false;
+    uint8_t _measMode = 0;
+    uint8_t _status = 0;
+    uint8_t _errorId = 0;
+    uint64_t _nextFrame = 0;
+    float _baselineOffset;
+    uint16_t _eCO2 = 0;
+    uint16_t _tvoc = 0;
+    uint16_t _raw = 0;
+    uint8_t _env[4];
+    uint16_t _lowToMed = 1500;
+    uint16_t _medToHigh = 2500;
+    uint8_t _hysteresis = 50;
+    uint8_t _band = 0;
+    bool _interrupt = false;
+    uint32_t _frames = 0;
+    uint32_t _envWrites = 0;
+
+    void reset();
+    void fail(uint8_t error);
+    uint64_t framePeriod();
+    uint8_t band(uint16_t eCO2);
+    void setInterrupt(bool asserted);
+    void frame(uint64_t at);
+    void writeMailbox(uint8_t reg, const uint8_t *data, uint8_t length);
+    void update(uint64_t now);
+public:
+    Ccs811Model(EnvironmentSource *source, int8_t intPin = -1);
+    void Receive(const uint8_t *data, uint8_t length);
+    uint8_t Request(uint8_t *data, uint8_t length);
+    void Tick(uint64_t micros);
+    uint16_t Baseline();
+    uint32_t Frames();
+    uint32_t EnvWrites();
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "environment.h"
+
+#define DAY_MICROS 86400000000ULL
+#define HOUR_MICROS 3600000000ULL
+#define OUTDOOR_CO2 420.0f   // ppm
+#define OUTDOOR_TVOC 5.0f    // ppb
+#define OCCUPIED_CO2 1400.0f // ppm a closed, occupied room settles at
+#define OCCUPIED_TVOC 250.0f // ppb
+#define AIR_CHANGE_SECONDS 1800.0f
+
+StaticEnvironment::StaticEnvironment(float temperature, float humidity, float pressure, float eCO2, float tvoc)
+{
+    air.temperature = temperature;
+    air.humidity = humidity;
+    air.pressure = pressure;
+    air.eCO2 = eCO2;
+    air.tvoc = tvoc;
+}
+
+void StaticEnvironment::Sample(uint64_t micros, Environment &out)
+{
+    out = air;
+}
+
+SyntheticEnvironment::SyntheticEnvironment(uint32_t seed)
+{
+    _state = seed ? seed : 1;
+    _eCO2 = OUTDOOR_CO2;
+    _tvoc = OUTDOOR_TVOC;
+}
+
+// xorshift32, uniform in [-amplitude, amplitude]
+float SyntheticEnvironment::noise(float amplitude)
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return amplitude * ((float)(_state & 0xFFFF) / 32767.5f - 1.0f);
+}
+
+// 08:00-12:00 and 13:00-18:00 of every day
+bool SyntheticEnvironment::occupied(uint64_t micros)
+{
+    uint64_t hour = micros % DAY_MICROS / HOUR_MICROS;
+
+    return (hour >= 8 && hour < 12) || (hour >= 13 && hour < 18);
+}
+
+void SyntheticEnvironment::Sample(uint64_t micros, Environment &out)
+{
+    float day = (float)(micros % DAY_MICROS) / DAY_MICROS;
+    float phase = 2.0f * (float)M_PI * (day - 0.375f); // coolest at 03:00, warmest at 15:00
+
+    if (!_started || micros < _last)
+    {
+        _last = micros;
+        _started = true;
+    }
+
+    // first order approach to the level the room heads for right now
+    float seconds = (float)(micros - _last) / 1e6f;
+    float k = 1.0f - expf(-seconds / AIR_CHANGE_SECONDS);
+    bool busy = occupied(micros);
+
+    _eCO2 += ((busy ? OCCUPIED_CO2 : OUTDOOR_CO2) - _eCO2) * k;
+    _tvoc += ((busy ? OCCUPIED_TVOC : OUTDOOR_TVOC) - _tvoc) * k;
+    _last = micros;
+
+    out.temperature = 21.0f - 2.0f * cosf(phase) + noise(0.05f);
+    out.humidity = 45.0f + 8.0f * cosf(phase) + noise(0.3f);
+    out.pressure = 101325.0f + 300.0f * sinf(2.0f * (float)M_PI * (float)micros / (3.0f * DAY_MICROS)) + noise(3.0f);
+    out.eCO2 = _eCO2 + noise(5.0f);
+    out.tvoc = _tvoc + noise(2.0f);
+}
+
+TraceEnvironment::TraceEnvironment(uint64_t origin)
+{
+    _origin = origin;
+}
+
+TraceEnvironment::~TraceEnvironment()
+{
+    free(_rows);
+}
+
+bool TraceEnvironment::append(const Row &row)
+{
+    if (_count == _capacity)
+    {
+        size_t capacity = _capacity ? _capacity * 2 : 64;
+        Row *rows = (Row *)realloc(_rows, capacity * sizeof(Row));
+
+        if (rows == nullptr)
+        {
+            return false;
+        }
+
+        _rows = rows;
+        _capacity = capacity;
+    }
+
+    _rows[_count++] = row;
+    return true;
+}
+
+// false when the file can't be read, has no rows or goes back in time
+bool TraceEnvironment::Load(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[160];
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    _count = 0;
+    _cursor = 0;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        Row row;
+        double seconds;
+        float hectopascal;
+
+        if (sscanf(line, "%lf,%f,%f,%f,%f,%f", &seconds, &row.air.temperature, &row.air.humidity, &hectopascal, &row.air.eCO2, &row.air.tvoc) != 6)
+        {
+            continue;
+        }
+
+        row.micros = (uint64_t)(seconds * 1e6);
+        row.air.pressure = hectopascal * 100.0f;
+
+        if (seconds < 0 || (_count > 0 && row.micros < _rows[_count - 1].micros) || !append(row))
+        {
+            fclose(file);
+            _count = 0;
+            return false;
+        }
+    }
+
+    fclose(file);
+    return _count > 0;
+}
+
+size_t TraceEnvironment::Rows()
+{
+    return _count;
+}
+
+// time of the last row
+uint64_t TraceEnvironment::Length()
+{
+    return _count ? _rows[_count - 1].micros : 0;
+}
+
+void TraceEnvironment::Sample(uint64_t micros, Environment &out)
+{
+    if (_count == 0)
+    {
+        return;
+    }
+
+    uint64_t at = micros > _origin ? micros - _origin : 0;
+
+    // the models sample forward in time, walk on from the last row used
+    if (_cursor >= _count || _rows[_cursor].micros > at)
+    {
+        _cursor = 0;
+    }
+
+    while (_cursor + 1 < _count && _rows[_cursor + 1].micros <= at)
+    {
+        _cursor++;
+    }
+
+    const Row &from = _rows[_cursor];
+
+    if (_cursor + 1 >= _count || at <= from.micros)
+    {
+        out = from.air;
+        return;
+    }
+
+    const Row &to = _rows[_cursor + 1];
+    float t = (float)(at - from.micros) / (float)(to.micros - from.micros);
+
+    out.temperature = from.air.temperature + (to.air.temperature - from.air.temperature) * t;
+    out.humidity = from.air.humidity + (to.air.humidity - from.air.humidity) * t;
+    out.pressure = from.air.pressure + (to.air.pressure - from.air.pressure) * t;
+    out.eCO2 = from.air.eCO2 + (to.air.eCO2 - from.air.eCO2) * t;
+    out.tvoc = from.air.tvoc + (to.air.tvoc - from.air.tvoc) * t;
+}
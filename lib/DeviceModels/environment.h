@@ -0,0 +1,88 @@
+#ifndef ENVIRONMENT
+#define ENVIRONMENT
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+// What the sensor models measure at a moment of device time.
+struct Environment
+{
+    float temperature; // C
+    float humidity;    // %RH
+    float pressure;    // Pa
+    float eCO2;        // ppm
+    float tvoc;        // ppb
+};
+
+// Where the models get the air from, scripted traces or generated signals.
+class EnvironmentSource
+{
+public:
+    virtual ~EnvironmentSource() {}
+    virtual void Sample(uint64_t micros, Environment &out) = 0;
+};
+
+// Fixed values, changed by the harness whenever it likes.
+class StaticEnvironment : public EnvironmentSource
+{
+public:
+    Environment air;
+
+    StaticEnvironment(float temperature = 22.0f, float humidity = 45.0f, float pressure = 101325.0f, float eCO2 = 450.0f, float tvoc = 10.0f);
+    void Sample(uint64_t micros, Environment &out);
+};
+
+// A room over the day: temperature and humidity follow a daily cycle,
+// pressure drifts slowly, and CO2/TVOC rise while the room is occupied
+// and decay towards outdoor air otherwise. A seeded noise term keeps it
+// deterministic run to run.
+class SyntheticEnvironment : public EnvironmentSource
+{
+private:
+    uint32_t _state;
+    uint64_t _last;
+    bool _started = false;
+    float _eCO2;
+    float _tvoc;
+
+    float noise(float amplitude);
+    bool occupied(uint64_t micros);
+public:
+    SyntheticEnvironment(uint32_t seed = 1);
+    void Sample(uint64_t micros, Environment &out);
+};
+
+// Recorded or prepared air from a CSV file, one row per point in time:
+//   seconds,temperature_c,humidity_pct,pressure_hpa,eco2_ppm,tvoc_ppb
+// Seconds count from the origin given to the constructor, rows must be in
+// time order. Values are interpolated between rows and held before the
+// first and after the last one. Lines that don't start with a number, like
+// a header or comments, are skipped.
+class TraceEnvironment : public EnvironmentSource
+{
+private:
+    struct Row
+    {
+        uint64_t micros;
+        Environment air;
+    };
+
+    Row *_rows = nullptr;
+    size_t _count = 0;
+    size_t _capacity = 0;
+    uint64_t _origin;
+    size_t _cursor = 0;
+
+    bool append(const Row &row);
+public:
+    TraceEnvironment(uint64_t origin = 0);
+    ~TraceEnvironment();
+    bool Load(const char *path);
+    size_t Rows();
+    uint64_t Length();
+    void Sample(uint64_t micros, Environment &out);
+};
+
+#endif
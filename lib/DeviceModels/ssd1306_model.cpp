@@ -0,0 +1,273 @@
+#include "ssd1306_model.h"
+
+#define CONTROL_CO 0x80 // one byte follows, then another control byte
+#define CONTROL_DC 0x40 // data, GDDRAM writes
+
+#define ADDRESSING_HORIZONTAL 0
+#define ADDRESSING_VERTICAL 1
+
+Ssd1306Model::Ssd1306Model()
+{
+    memset(_ram, 0, sizeof(_ram));
+}
+
+uint8_t Ssd1306Model::argCount(uint8_t command)
+{
+    switch (command)
+    {
+    case 0x20: // memory addressing mode
+    case 0x81: // contrast
+    case 0x8D: // charge pump
+    case 0xA8: // multiplex ratio
+    case 0xD3: // display offset
+    case 0xD5: // clock divide
+    case 0xD9: // pre-charge
+    case 0xDA: // COM pins
+    case 0xDB: // VCOMH deselect
+        return 1;
+    case 0x21: // column address
+    case 0x22: // page address
+    case 0xA3: // vertical scroll area
+        return 2;
+    case 0x29: // vertical and horizontal scroll setup
+    case 0x2A:
+        return 5;
+    case 0x26: // horizontal scroll setup
+    case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+void Ssd1306Model::command(uint8_t c)
+{
+    if (_commandLength == 0)
+    {
+        _commandNeeded = argCount(c);
+    }
+
+    _command[_commandLength++] = c;
+
+    if (_commandLength > _commandNeeded)
+    {
+        execute();
+        _commandLength = 0;
+        _commands++;
+    }
+}
+
+void Ssd1306Model::execute()
+{
+    uint8_t c = _command[0];
+
+    if (c <= 0x0F)
+    {
+        _col = (_col & 0xF0) | c;
+        return;
+    }
+
+    if (c <= 0x1F)
+    {
+        _col = ((c & 0x07) << 4) | (_col & 0x0F);
+        return;
+    }
+
+    if (c >= 0x40 && c <= 0x7F)
+    {
+        _startLine = c & 0x3F;
+        return;
+    }
+
+    if (c >= 0xB0 && c <= 0xB7)
+    {
+        _page = c & 0x07;
+        return;
+    }
+
+    switch (c)
+    {
+    case 0x20:
+        _addressing = _command[1] & 0x03;
+        break;
+    case 0x21:
+        _colStart = _command[1] & 0x7F;
+        _colEnd = _command[2] & 0x7F;
+        _col = _colStart;
+        break;
+    case 0x22:
+        _pageStart = _command[1] & 0x07;
+        _pageEnd = _command[2] & 0x07;
+        _page = _pageStart;
+        break;
+    case 0x2E:
+        _scrolling = false;
+        break;
+    case 0x2F:
+        _scrolling = true;
+        break;
+    case 0x81:
+        _contrast = _command[1];
+        break;
+    case 0x8D:
+        _chargePump = _command[1] & 0x04;
+        break;
+    case 0xA6:
+        _inverted = false;
+        break;
+    case 0xA7:
+        _inverted = true;
+        break;
+    case 0xA8:
+        _multiplex = _command[1] & 0x3F;
+        break;
+    case 0xAE:
+        _on = false;
+        break;
+    case 0xAF:
+        _on = true;
+        break;
+    case 0xD3:
+        _offset = _command[1] & 0x3F;
+        break;
+    default:
+        // segment remap, COM scan direction, timing: no effect on GDDRAM
+        break;
+    }
+}
+
+void Ssd1306Model::data(uint8_t d)
+{
+    _ram[_page][_col] = d;
+    _dataBytes++;
+
+    if (_scrolling)
+    {
+        _scrollWrites++;
+    }
+
+    switch (_addressing)
+    {
+    case ADDRESSING_HORIZONTAL:
+        if (_col++ >= _colEnd)
+        {
+            _col = _colStart;
+            _page = _page >= _pageEnd ? _pageStart : _page + 1;
+        }
+        break;
+    case ADDRESSING_VERTICAL:
+        if (_page++ >= _pageEnd)
+        {
+            _page = _pageStart;
+            _col = _col >= _colEnd ? _colStart : _col + 1;
+        }
+        break;
+    default:
+        _col = (_col + 1) & (SSD1306_MODEL_COLUMNS - 1);
+        break;
+    }
+}
+
+void Ssd1306Model::Receive(const uint8_t *bytes, uint8_t length)
+{
+    uint8_t i = 0;
+
+    while (i < length)
+    {
+        uint8_t control = bytes[i++];
+
+        if (control & CONTROL_CO)
+        {
+            if (i < length)
+            {
+                uint8_t b = bytes[i++];
+                (control & CONTROL_DC) ? data(b) : command(b);
+            }
+            continue;
+        }
+
+        // the rest of the transaction is all data or all commands
+        for (; i < length; i++)
+        {
+            (control & CONTROL_DC) ? data(bytes[i]) : command(bytes[i]);
+        }
+    }
+}
+
+// the status byte, D6 set while the display is off
+uint8_t Ssd1306Model::Request(uint8_t *bytes, uint8_t length)
+{
+    for (uint8_t i = 0; i < length; i++)
+    {
+        bytes[i] = _on ? 0x00 : 0x40;
+    }
+
+    return length;
+}
+
+bool Ssd1306Model::Pixel(uint8_t x, uint8_t y)
+{
+    if (x >= SSD1306_MODEL_COLUMNS || y >= SSD1306_MODEL_PAGES * 8)
+    {
+        return false;
+    }
+
+    return _ram[y / 8][x] & (1 << (y & 7));
+}
+
+const uint8_t *Ssd1306Model::Page(uint8_t page)
+{
+    return _ram[page & (SSD1306_MODEL_PAGES - 1)];
+}
+
+bool Ssd1306Model::IsOn()
+{
+    return _on;
+}
+
+bool Ssd1306Model::IsInverted()
+{
+    return _inverted;
+}
+
+bool Ssd1306Model::Scrolling()
+{
+    return _scrolling;
+}
+
+uint8_t Ssd1306Model::Contrast()
+{
+    return _contrast;
+}
+
+uint32_t Ssd1306Model::Commands()
+{
+    return _commands;
+}
+
+uint32_t Ssd1306Model::DataBytes()
+{
+    return _dataBytes;
+}
+
+uint32_t Ssd1306Model::ScrollWrites()
+{
+    return _scrollWrites;
+}
+
+// plain PBM of what the panel shows, blank while it is off
+void Ssd1306Model::WritePbm(FILE *file, uint8_t width, uint8_t height)
+{
+    fprintf(file, "P1\n%d %d\n", width, height);
+
+    for (uint8_t y = 0; y < height; y++)
+    {
+        for (uint8_t x = 0; x < width; x++)
+        {
+            bool lit = _on && (Pixel(x, y) != _inverted);
+            fputc(lit ? '1' : '0', file);
+        }
+
+        fputc('\n', file);
+    }
+}
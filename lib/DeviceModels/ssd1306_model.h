@@ -0,0 +1,67 @@
+#ifndef SSD1306_MODEL
+#define SSD1306_MODEL
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#include <Wire.h>
+
+#define SSD1306_MODEL_COLUMNS 128
+#define SSD1306_MODEL_PAGES 8
+#define SSD1306_MODEL_MAX_ARGS 6
+
+// SSD1306 controller on the fake bus. Decodes the control bytes, the
+// command stream with its arguments (split across transactions like the
+// Adafruit library does) and GDDRAM writes in horizontal, vertical and page
+// addressing mode. GDDRAM can be read back or captured as the panel would
+// show it, scrolling aside. Writes that land while a hardware scroll is
+// active are counted, the datasheet leaves their effect undefined.
+class Ssd1306Model : public WireDevice
+{
+private:
+    uint8_t _ram[SSD1306_MODEL_PAGES][SSD1306_MODEL_COLUMNS];
+    uint8_t _command[SSD1306_MODEL_MAX_ARGS + 1];
+    uint8_t _commandLength = 0;
+    uint8_t _commandNeeded = 0;
+    uint8_t _addressing = 2; // page addressing after reset
+    uint8_t _colStart = 0;
+    uint8_t _colEnd = SSD1306_MODEL_COLUMNS - 1;
+    uint8_t _pageStart = 0;
+    uint8_t _pageEnd = SSD1306_MODEL_PAGES - 1;
+    uint8_t _col = 0;
+    uint8_t _page = 0;
+    uint8_t _contrast = 0x7F;
+    uint8_t _multiplex = 63;
+    uint8_t _startLine = 0;
+    uint8_t _offset = 0;
+    bool _on = false;
+    bool _inverted = false;
+    bool _scrolling = false;
+    bool _chargePump = false;
+    uint32_t _commands = 0;
+    uint32_t _dataBytes = 0;
+    uint32_t _scrollWrites = 0;
+
+    uint8_t argCount(uint8_t command);
+    void command(uint8_t c);
+    void execute();
+    void data(uint8_t d);
+public:
+    Ssd1306Model();
+    void Receive(const uint8_t *data, uint8_t length);
+    uint8_t Request(uint8_t *data, uint8_t length);
+    bool Pixel(uint8_t x, uint8_t y);
+    const uint8_t *Page(uint8_t page);
+    bool IsOn();
+    bool IsInverted();
+    bool Scrolling();
+    uint8_t Contrast();
+    uint32_t Commands();
+    uint32_t DataBytes();
+    uint32_t ScrollWrites();
+    void WritePbm(FILE *file, uint8_t width, uint8_t height);
+};
+
+#endif
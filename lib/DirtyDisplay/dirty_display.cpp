@@ -0,0 +1,157 @@
+#include "dirty_display.h"
+
+DirtyDisplay::DirtyDisplay(Adafruit_SSD1306 *display, TwoWire *wire, uint8_t addr, uint32_t clkDuring, uint32_t clkAfter)
+{
+    _display = display;
+    _wire = wire;
+    _addr = addr;
+    _clkDuring = clkDuring;
+    _clkAfter = clkAfter;
+    memset(_firstCol, DIRTY_CLEAN, sizeof(_firstCol));
+    memset(_lastCol, 0, sizeof(_lastCol));
+}
+
+uint8_t DirtyDisplay::pages()
+{
+    uint8_t count = (_display->height() + 7) / 8;
+    return count > DIRTY_MAX_PAGES ? DIRTY_MAX_PAGES : count;
+}
+
+void DirtyDisplay::MarkDirty(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    int16_t right = x + w - 1;
+    int16_t bottom = y + h - 1;
+
+    if (w <= 0 || h <= 0 || right < 0 || bottom < 0 || x >= _display->width() || y >= _display->height())
+    {
+        return;
+    }
+
+    if (x < 0)
+    {
+        x = 0;
+    }
+    if (y < 0)
+    {
+        y = 0;
+    }
+    if (right >= _display->width())
+    {
+        right = _display->width() - 1;
+    }
+    if (bottom >= _display->height())
+    {
+        bottom = _display->height() - 1;
+    }
+
+    for (uint8_t page = y / 8; page <= bottom / 8 && page < DIRTY_MAX_PAGES; page++)
+    {
+        if (_firstCol[page] == DIRTY_CLEAN || x < _firstCol[page])
+        {
+            _firstCol[page] = x;
+        }
+        if (right > _lastCol[page])
+        {
+            _lastCol[page] = right;
+        }
+    }
+}
+
+void DirtyDisplay::MarkAll()
+{
+    MarkDirty(0, 0, _display->width(), _display->height());
+}
+
+bool DirtyDisplay::IsDirty()
+{
+    for (uint8_t page = 0; page < pages(); page++)
+    {
+        if (_firstCol[page] != DIRTY_CLEAN)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DirtyDisplay::Flush()
+{
+    uint8_t count = pages();
+    uint8_t page = 0;
+
+    if (!IsDirty())
+    {
+        return;
+    }
+
+    _wire->setClock(_clkDuring);
+
+    while (page < count)
+    {
+        if (_firstCol[page] == DIRTY_CLEAN)
+        {
+            page++;
+            continue;
+        }
+
+        // pages with the same column range go out as one window, the
+        // controller wraps to the next page at the end of each row
+        uint8_t lastPage = page;
+        while (lastPage + 1 < count && _firstCol[lastPage + 1] == _firstCol[page] && _lastCol[lastPage + 1] == _lastCol[page])
+        {
+            lastPage++;
+        }
+
+        sendWindow(page, lastPage, _firstCol[page], _lastCol[page]);
+
+        for (; page <= lastPage; page++)
+        {
+            _firstCol[page] = DIRTY_CLEAN;
+            _lastCol[page] = 0;
+        }
+    }
+
+    _wire->setClock(_clkAfter);
+}
+
+void DirtyDisplay::sendWindow(uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol)
+{
+    uint8_t *buffer = _display->getBuffer();
+    uint8_t width = _display->width();
+    uint8_t sent = 1;
+
+    _wire->beginTransmission(_addr);
+    _wire->write(DIRTY_CONTROL_COMMAND);
+    _wire->write(SSD1306_PAGEADDR);
+    _wire->write(firstPage);
+    _wire->write(lastPage);
+    _wire->write(SSD1306_COLUMNADDR);
+    _wire->write(firstCol);
+    _wire->write(lastCol);
+    _wire->endTransmission();
+
+    _wire->beginTransmission(_addr);
+    _wire->write(DIRTY_CONTROL_DATA);
+
+    for (uint8_t page = firstPage; page <= lastPage; page++)
+    {
+        uint8_t *row = buffer + (uint16_t)page * width;
+
+        for (uint8_t col = firstCol; col <= lastCol; col++)
+        {
+            if (sent >= DIRTY_WIRE_MAX)
+            {
+                _wire->endTransmission();
+                _wire->beginTransmission(_addr);
+                _wire->write(DIRTY_CONTROL_DATA);
+                sent = 1;
+            }
+
+            _wire->write(row[col]);
+            sent++;
+        }
+    }
+
+    _wire->endTransmission();
+}
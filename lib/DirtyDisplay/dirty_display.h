@@ -0,0 +1,47 @@
+#ifndef DIRTY_DISPLAY
+#define DIRTY_DISPLAY
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+
+#define DIRTY_MAX_PAGES 8          // 128x64 panels, 128x32 only uses 4
+#define DIRTY_CONTROL_COMMAND 0x00 // Co = 0, D/C# = 0
+#define DIRTY_CONTROL_DATA 0x40    // Co = 0, D/C# = 1
+#define DIRTY_CLEAN 0xFF           // first column of a page with nothing to send
+
+#ifdef BUFFER_LENGTH
+#define DIRTY_WIRE_MAX BUFFER_LENGTH // twi buffer incl. the control byte
+#else
+#define DIRTY_WIRE_MAX 32
+#endif
+
+// Sends only the parts of the Adafruit_SSD1306 framebuffer that were marked
+// as changed, using page/column addressing instead of a full display() push.
+// Assumes the horizontal addressing mode Adafruit_SSD1306::begin() sets up.
+class DirtyDisplay
+{
+private:
+    Adafruit_SSD1306 *_display;
+    TwoWire *_wire;
+    uint8_t _addr;
+    uint32_t _clkDuring;
+    uint32_t _clkAfter;
+    uint8_t _firstCol[DIRTY_MAX_PAGES];
+    uint8_t _lastCol[DIRTY_MAX_PAGES];
+
+    uint8_t pages();
+    void sendWindow(uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol);
+public:
+    DirtyDisplay(Adafruit_SSD1306 *display, TwoWire *wire, uint8_t addr, uint32_t clkDuring = 400000UL, uint32_t clkAfter = 100000UL);
+    void MarkDirty(int16_t x, int16_t y, int16_t w, int16_t h);
+    void MarkAll();
+    bool IsDirty();
+    void Flush();
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "fixed_format.h"
+
+static const uint32_t powersOfTen[] PROGMEM = {
+    1UL,
+    10UL,
+    100UL,
+    1000UL,
+    10000UL,
+    100000UL,
+    1000000UL,
+    10000000UL,
+    100000000UL,
+    1000000000UL};
+
+static uint32_t powerOfTen(int8_t exponent)
+{
+    return pgm_read_dword(&powersOfTen[exponent]);
+}
+
+size_t formatFixed(char *out, int32_t value, uint8_t scale, uint8_t decimals)
+{
+    bool negative = value < 0;
+    bool nonZero = false;
+    uint32_t remaining = negative ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    char *cursor = out + 1; // out[0] is kept for the sign
+    int8_t top = 9;
+    int8_t last;
+
+    if (scale > FIXED_MAX_SCALE)
+    {
+        scale = FIXED_MAX_SCALE;
+    }
+    if (decimals > FIXED_MAX_DECIMALS)
+    {
+        decimals = FIXED_MAX_DECIMALS;
+    }
+
+    last = scale > decimals ? scale - decimals : 0;
+
+    if (decimals < scale)
+    {
+        uint32_t half = 5 * powerOfTen(scale - decimals - 1);
+
+        if (remaining <= 0xFFFFFFFFUL - half)
+        {
+            remaining += half;
+        }
+    }
+
+    // skip leading zeros, but always keep the ones digit
+    while (top > (int8_t)scale && remaining < powerOfTen(top))
+    {
+        top--;
+    }
+
+    for (int8_t i = top; i >= last; i--)
+    {
+        uint32_t power = powerOfTen(i);
+        char digit = '0';
+
+        while (remaining >= power)
+        {
+            remaining -= power;
+            digit++;
+        }
+
+        if (i == (int8_t)scale - 1)
+        {
+            *cursor++ = '.';
+        }
+
+        nonZero |= digit != '0';
+        *cursor++ = digit;
+    }
+
+    if (decimals > scale)
+    {
+        if (scale == 0)
+        {
+            *cursor++ = '.';
+        }
+
+        for (uint8_t i = scale; i < decimals; i++)
+        {
+            *cursor++ = '0';
+        }
+    }
+
+    *cursor = '\0';
+
+    // no "-0.0" when the rounded value is zero
+    if (negative && nonZero)
+    {
+        out[0] = '-';
+        return cursor - out;
+    }
+
+    memmove(out, out + 1, cursor - out);
+    return cursor - out - 1;
+}
+
+size_t printFixed(Print &out, int32_t value, uint8_t scale, uint8_t decimals)
+{
+    char text[FIXED_FORMAT_SIZE];
+    size_t length = formatFixed(text, value, scale, decimals);
+
+    return out.write((const uint8_t *)text, length);
+}
+
+int32_t centiCelsiusToFahrenheit(int32_t centiCelsius)
+{
+    int32_t scaled = centiCelsius * 9;
+
+    return (scaled >= 0 ? scaled + 2 : scaled - 2) / 5 + 3200;
+}
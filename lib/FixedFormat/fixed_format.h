@@ -0,0 +1,25 @@
+#ifndef FIXED_FORMAT
+#define FIXED_FORMAT
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define FIXED_MAX_SCALE 9    // 10^9 is the largest power of ten in a uint32_t
+#define FIXED_MAX_DECIMALS 9
+#define FIXED_FORMAT_SIZE 22 // sign, 10 digits, point, 9 decimals, terminator
+
+// Renders value / 10^scale with the given number of decimals, rounded half
+// away from zero, using only additions, subtractions and a power-of-ten
+// table, no division or float. out needs FIXED_FORMAT_SIZE bytes.
+// Returns the number of characters written, excluding the terminator.
+size_t formatFixed(char *out, int32_t value, uint8_t scale, uint8_t decimals);
+
+// formatFixed() straight into any Print (TextBuffer, Serial, the display).
+size_t printFixed(Print &out, int32_t value, uint8_t scale, uint8_t decimals);
+
+// Centi-degrees Celsius to centi-degrees Fahrenheit, rounded.
+int32_t centiCelsiusToFahrenheit(int32_t centiCelsius);
+
+#endif
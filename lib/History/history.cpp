@@ -0,0 +1,190 @@
+#include "history.h"
+
+#define HISTORY_NIBBLES (HISTORY_BYTES * 2)
+
+History::History()
+{
+    Clear();
+}
+
+void History::Clear()
+{
+    _start = 0;
+    _length = 0;
+    _count = 0;
+}
+
+static uint32_t zigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unZigZag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+uint8_t History::nibbleAt(uint16_t position)
+{
+    if (position >= HISTORY_NIBBLES)
+    {
+        position -= HISTORY_NIBBLES;
+    }
+
+    uint8_t byte = _nibbles[position >> 1];
+    return position & 1 ? byte >> 4 : byte & 0x0F;
+}
+
+void History::putNibble(uint8_t nibble)
+{
+    uint16_t position = _start + _length;
+
+    if (position >= HISTORY_NIBBLES)
+    {
+        position -= HISTORY_NIBBLES;
+    }
+
+    uint8_t &byte = _nibbles[position >> 1];
+    byte = position & 1 ? (byte & 0x0F) | (nibble << 4) : (byte & 0xF0) | nibble;
+    _length++;
+}
+
+uint32_t History::readVarint(uint16_t &position)
+{
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    uint8_t nibble;
+
+    do
+    {
+        nibble = nibbleAt(position++);
+        value |= (uint32_t)(nibble & 0x07) << shift;
+        shift += 3;
+    } while (nibble & 0x08);
+
+    if (position >= HISTORY_NIBBLES)
+    {
+        position -= HISTORY_NIBBLES;
+    }
+
+    return value;
+}
+
+uint8_t History::varintLength(uint32_t value)
+{
+    uint8_t length = 1;
+
+    while (value >= 0x08)
+    {
+        value >>= 3;
+        length++;
+    }
+
+    return length;
+}
+
+void History::dropOldest()
+{
+    if (_count <= 1)
+    {
+        Clear();
+        return;
+    }
+
+    // the second record becomes the new base
+    uint16_t position = _start;
+
+    for (uint8_t i = 0; i < HISTORY_CHANNELS; i++)
+    {
+        _base[i] += unZigZag(readVarint(position));
+    }
+
+    _length -= (position + HISTORY_NIBBLES - _start) % HISTORY_NIBBLES;
+    _start = position;
+    _count--;
+}
+
+void History::Append(const int32_t *values)
+{
+    if (_count == 0)
+    {
+        memcpy(_base, values, sizeof(_base));
+        memcpy(_last, values, sizeof(_last));
+        _count = 1;
+        return;
+    }
+
+    uint32_t deltas[HISTORY_CHANNELS];
+    uint8_t needed = 0;
+
+    for (uint8_t i = 0; i < HISTORY_CHANNELS; i++)
+    {
+        deltas[i] = zigZag(values[i] - _last[i]);
+        needed += varintLength(deltas[i]);
+    }
+
+    while (_count == 0xFF || HISTORY_NIBBLES - _length < needed)
+    {
+        dropOldest();
+
+        if (_count == 0)
+        {
+            Append(values);
+            return;
+        }
+    }
+
+    for (uint8_t i = 0; i < HISTORY_CHANNELS; i++)
+    {
+        uint32_t value = deltas[i];
+
+        while (value >= 0x08)
+        {
+            putNibble((value & 0x07) | 0x08);
+            value >>= 3;
+        }
+
+        putNibble(value);
+    }
+
+    memcpy(_last, values, sizeof(_last));
+    _count++;
+}
+
+uint8_t History::Count()
+{
+    return _count;
+}
+
+uint16_t History::Used()
+{
+    return (_length + 1) / 2;
+}
+
+// oldest record first, each Next() fills cursor.values with the following one
+void History::Begin(Cursor &cursor)
+{
+    cursor.position = _start;
+    cursor.remaining = _count;
+    memcpy(cursor.values, _base, sizeof(cursor.values));
+}
+
+bool History::Next(Cursor &cursor)
+{
+    if (cursor.remaining == 0)
+    {
+        return false;
+    }
+
+    if (cursor.remaining-- == _count)
+    {
+        return true; // the base record, values are already set
+    }
+
+    for (uint8_t i = 0; i < HISTORY_CHANNELS; i++)
+    {
+        cursor.values[i] += unZigZag(readVarint(cursor.position));
+    }
+
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef HISTORY
+#define HISTORY
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define HISTORY_CHANNELS 5
+#define HISTORY_BYTES 64 // SRAM, sized to what the framebuffer leaves
+
+// Reading history in a fixed byte budget. The oldest record is kept as
+// plain values, every later one as zig-zag deltas to its predecessor in
+// nibble varints (3 data bits and a continuation bit), so a quiet channel
+// costs half a byte per record. Appending is O(1), full buffers drop the
+// oldest record by folding it into the base values.
+class History
+{
+public:
+    struct Cursor
+    {
+        uint16_t position;
+        uint8_t remaining;
+        int32_t values[HISTORY_CHANNELS];
+    };
+
+private:
+    uint8_t _nibbles[HISTORY_BYTES];
+    uint16_t _start;  // nibble index of the first delta record
+    uint16_t _length; // nibbles in use
+    uint8_t _count;   // records, including the base
+    int32_t _base[HISTORY_CHANNELS];
+    int32_t _last[HISTORY_CHANNELS];
+
+    uint8_t nibbleAt(uint16_t position);
+    void putNibble(uint8_t nibble);
+    uint32_t readVarint(uint16_t &position);
+    uint8_t varintLength(uint32_t value);
+    void dropOldest();
+public:
+    History();
+    void Clear();
+    void Append(const int32_t *values);
+    uint8_t Count();
+    uint16_t Used(); // bytes, rounded up
+    void Begin(Cursor &cursor);
+    bool Next(Cursor &cursor);
+};
+
+#endif
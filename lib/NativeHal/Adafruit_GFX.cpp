@@ -0,0 +1,216 @@
+#include "Adafruit_GFX.h"
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h)
+{
+    _width = w;
+    _height = h;
+}
+
+// 7 rows per column like the real font, never blank so every glyph shows up
+uint8_t Adafruit_GFX::glyphColumn(unsigned char c, uint8_t column)
+{
+    if (c == ' ')
+    {
+        return 0;
+    }
+
+    return (uint8_t)((c * 37 + column * 101) % 127 + 1);
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    for (int16_t j = y; j < y + h; j++)
+    {
+        for (int16_t i = x; i < x + w; i++)
+        {
+            drawPixel(i, j, color);
+        }
+    }
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color)
+{
+    fillRect(0, 0, _width, _height, color);
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size)
+{
+    if (x >= _width || y >= _height || x + GFX_CHAR_WIDTH * size - 1 < 0 || y + GFX_CHAR_HEIGHT * size - 1 < 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < GFX_CHAR_WIDTH - 1; i++)
+    {
+        uint8_t line = glyphColumn(c, i);
+
+        for (uint8_t j = 0; j < GFX_CHAR_HEIGHT; j++, line >>= 1)
+        {
+            if (line & 1)
+            {
+                fillRect(x + i * size, y + j * size, size, size, color);
+            }
+            else if (bg != color)
+            {
+                fillRect(x + i * size, y + j * size, size, size, bg);
+            }
+        }
+    }
+
+    if (bg != color)
+    {
+        fillRect(x + (GFX_CHAR_WIDTH - 1) * size, y, size, GFX_CHAR_HEIGHT * size, bg);
+    }
+}
+
+size_t Adafruit_GFX::write(uint8_t c)
+{
+    if (c == '\n')
+    {
+        _cursorX = 0;
+        _cursorY += _textSize * GFX_CHAR_HEIGHT;
+    }
+    else if (c != '\r')
+    {
+        if (_wrap && _cursorX + _textSize * GFX_CHAR_WIDTH > _width)
+        {
+            _cursorX = 0;
+            _cursorY += _textSize * GFX_CHAR_HEIGHT;
+        }
+
+        drawChar(_cursorX, _cursorY, c, _textColor, _textBgColor, _textSize);
+        _cursorX += _textSize * GFX_CHAR_WIDTH;
+    }
+
+    return 1;
+}
+
+void Adafruit_GFX::charBounds(unsigned char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy)
+{
+    if (c == '\n')
+    {
+        *x = 0;
+        *y += _textSize * GFX_CHAR_HEIGHT;
+        return;
+    }
+
+    if (c == '\r')
+    {
+        return;
+    }
+
+    if (_wrap && *x + _textSize * GFX_CHAR_WIDTH > _width)
+    {
+        *x = 0;
+        *y += _textSize * GFX_CHAR_HEIGHT;
+    }
+
+    int16_t x2 = *x + _textSize * GFX_CHAR_WIDTH - 1;
+    int16_t y2 = *y + _textSize * GFX_CHAR_HEIGHT - 1;
+
+    if (x2 > *maxx)
+    {
+        *maxx = x2;
+    }
+
+    if (y2 > *maxy)
+    {
+        *maxy = y2;
+    }
+
+    if (*x < *minx)
+    {
+        *minx = *x;
+    }
+
+    if (*y < *miny)
+    {
+        *miny = *y;
+    }
+
+    *x += _textSize * GFX_CHAR_WIDTH;
+}
+
+void Adafruit_GFX::getTextBounds(const char *string, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+{
+    int16_t minx = 0x7FFF;
+    int16_t miny = 0x7FFF;
+    int16_t maxx = -1;
+    int16_t maxy = -1;
+
+    *x1 = x;
+    *y1 = y;
+    *w = 0;
+    *h = 0;
+
+    for (; *string; string++)
+    {
+        charBounds(*string, &x, &y, &minx, &miny, &maxx, &maxy);
+    }
+
+    if (maxx >= minx)
+    {
+        *x1 = minx;
+        *w = maxx - minx + 1;
+    }
+
+    if (maxy >= miny)
+    {
+        *y1 = miny;
+        *h = maxy - miny + 1;
+    }
+}
+
+void Adafruit_GFX::getTextBounds(const __FlashStringHelper *string, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h)
+{
+    getTextBounds((const char *)string, x, y, x1, y1, w, h);
+}
+
+void Adafruit_GFX::setCursor(int16_t x, int16_t y)
+{
+    _cursorX = x;
+    _cursorY = y;
+}
+
+void Adafruit_GFX::setTextSize(uint8_t size)
+{
+    _textSize = size > 0 ? size : 1;
+}
+
+// same color for both means a transparent background, as in the library
+void Adafruit_GFX::setTextColor(uint16_t color)
+{
+    _textColor = color;
+    _textBgColor = color;
+}
+
+void Adafruit_GFX::setTextColor(uint16_t color, uint16_t bg)
+{
+    _textColor = color;
+    _textBgColor = bg;
+}
+
+void Adafruit_GFX::setTextWrap(bool wrap)
+{
+    _wrap = wrap;
+}
+
+int16_t Adafruit_GFX::getCursorX() const
+{
+    return _cursorX;
+}
+
+int16_t Adafruit_GFX::getCursorY() const
+{
+    return _cursorY;
+}
+
+int16_t Adafruit_GFX::width() const
+{
+    return _width;
+}
+
+int16_t Adafruit_GFX::height() const
+{
+    return _height;
+}
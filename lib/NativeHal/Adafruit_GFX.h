@@ -0,0 +1,51 @@
+#ifndef NATIVE_GFX
+#define NATIVE_GFX
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define GFX_CHAR_WIDTH 6  // classic font cell incl. spacing, times the text size
+#define GFX_CHAR_HEIGHT 8
+
+// The Adafruit_GFX text path with the classic 6x8 cell. Cursor movement,
+// clipping and getTextBounds() follow the real library, so layout and dirty
+// rectangles are exact. Glyphs are stand-in patterns, one per character
+// code, since the font itself is not needed to test what gets drawn where.
+class Adafruit_GFX : public Print
+{
+protected:
+    int16_t _width;
+    int16_t _height;
+    int16_t _cursorX = 0;
+    int16_t _cursorY = 0;
+    uint16_t _textColor = 0xFFFF;
+    uint16_t _textBgColor = 0xFFFF;
+    uint8_t _textSize = 1;
+    bool _wrap = true;
+
+    uint8_t glyphColumn(unsigned char c, uint8_t column);
+    void charBounds(unsigned char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy);
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    virtual void fillScreen(uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+    void getTextBounds(const char *string, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+    void getTextBounds(const __FlashStringHelper *string, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h);
+    void setCursor(int16_t x, int16_t y);
+    void setTextSize(uint8_t size);
+    void setTextColor(uint16_t color);
+    void setTextColor(uint16_t color, uint16_t bg);
+    void setTextWrap(bool wrap);
+    int16_t getCursorX() const;
+    int16_t getCursorY() const;
+    int16_t width() const;
+    int16_t height() const;
+    size_t write(uint8_t c);
+    using Print::write;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "Adafruit_SSD1306.h"
+
+#define SSD1306_WIRE_MAX BUFFER_LENGTH // incl. the control byte
+
+Adafruit_SSD1306::Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi, int8_t rstPin, uint32_t clkDuring, uint32_t clkAfter) : Adafruit_GFX(w, h)
+{
+    _wire = twi;
+    _rstPin = rstPin;
+    _clkDuring = clkDuring;
+    _clkAfter = clkAfter;
+}
+
+Adafruit_SSD1306::~Adafruit_SSD1306()
+{
+    free(_buffer);
+}
+
+// one 0x00 control byte per transaction, continued while the twi buffer fills
+void Adafruit_SSD1306::commandList(const uint8_t *commands, uint8_t count)
+{
+    uint8_t sent = 1;
+
+    _wire->setClock(_clkDuring);
+    _wire->beginTransmission(_addr);
+    _wire->write((uint8_t)0x00);
+
+    while (count--)
+    {
+        if (sent >= SSD1306_WIRE_MAX)
+        {
+            _wire->endTransmission();
+            _wire->beginTransmission(_addr);
+            _wire->write((uint8_t)0x00);
+            sent = 1;
+        }
+
+        _wire->write(*commands++);
+        sent++;
+    }
+
+    _wire->endTransmission();
+    _wire->setClock(_clkAfter);
+}
+
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t i2caddr, bool reset, bool periphBegin)
+{
+    if (_buffer == nullptr && (_buffer = (uint8_t *)malloc(_width * ((_height + 7) / 8))) == nullptr)
+    {
+        return false;
+    }
+
+    clearDisplay();
+    _vccState = switchvcc;
+    _addr = i2caddr ? i2caddr : (_height == 32 ? 0x3C : 0x3D);
+
+    if (periphBegin)
+    {
+        _wire->begin();
+    }
+
+    if (reset && _rstPin >= 0)
+    {
+        pinMode(_rstPin, OUTPUT);
+        digitalWrite(_rstPin, HIGH);
+        delay(1);
+        digitalWrite(_rstPin, LOW);
+        delay(10);
+        digitalWrite(_rstPin, HIGH);
+    }
+
+    uint8_t init[] = {
+        SSD1306_DISPLAYOFF,
+        SSD1306_SETDISPLAYCLOCKDIV, 0x80,
+        SSD1306_SETMULTIPLEX, (uint8_t)(_height - 1),
+        SSD1306_SETDISPLAYOFFSET, 0x00,
+        SSD1306_SETSTARTLINE | 0x00,
+        SSD1306_CHARGEPUMP, (uint8_t)(switchvcc == SSD1306_EXTERNALVCC ? 0x10 : 0x14),
+        SSD1306_MEMORYMODE, 0x00,
+        SSD1306_SEGREMAP | 0x01,
+        SSD1306_COMSCANDEC,
+        SSD1306_SETCOMPINS, (uint8_t)(_height == 32 ? 0x02 : 0x12),
+        SSD1306_SETCONTRAST, (uint8_t)(_height == 32 ? 0x8F : (switchvcc == SSD1306_EXTERNALVCC ? 0x9F : 0xCF)),
+        SSD1306_SETPRECHARGE, (uint8_t)(switchvcc == SSD1306_EXTERNALVCC ? 0x22 : 0xF1),
+        SSD1306_SETVCOMDETECT, 0x40,
+        SSD1306_DISPLAYALLON_RESUME,
+        SSD1306_NORMALDISPLAY,
+        SSD1306_DEACTIVATE_SCROLL,
+        SSD1306_DISPLAYON};
+
+    commandList(init, sizeof(init));
+    return true;
+}
+
+void Adafruit_SSD1306::display()
+{
+    uint16_t count = _width * ((_height + 7) / 8);
+    uint8_t *ptr = _buffer;
+    uint8_t window[] = {SSD1306_PAGEADDR, 0, 0xFF, SSD1306_COLUMNADDR, 0, (uint8_t)(_width - 1)};
+
+    commandList(window, sizeof(window));
+
+    _wire->setClock(_clkDuring);
+    _wire->beginTransmission(_addr);
+    _wire->write((uint8_t)0x40);
+
+    for (uint8_t sent = 1; count--; sent++)
+    {
+        if (sent >= SSD1306_WIRE_MAX)
+        {
+            _wire->endTransmission();
+            _wire->beginTransmission(_addr);
+            _wire->write((uint8_t)0x40);
+            sent = 1;
+        }
+
+        _wire->write(*ptr++);
+    }
+
+    _wire->endTransmission();
+    _wire->setClock(_clkAfter);
+    _frames++;
+}
+
+void Adafruit_SSD1306::clearDisplay()
+{
+    memset(_buffer, 0, _width * ((_height + 7) / 8));
+}
+
+void Adafruit_SSD1306::invertDisplay(bool i)
+{
+    ssd1306_command(i ? SSD1306_INVERTDISPLAY : SSD1306_NORMALDISPLAY);
+}
+
+void Adafruit_SSD1306::dim(bool dim)
+{
+    uint8_t contrast[] = {SSD1306_SETCONTRAST, (uint8_t)(dim ? 0 : (_vccState == SSD1306_EXTERNALVCC ? 0x9F : 0xCF))};
+
+    commandList(contrast, sizeof(contrast));
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (x < 0 || x >= _width || y < 0 || y >= _height)
+    {
+        return;
+    }
+
+    uint8_t *cell = &_buffer[x + (y / 8) * _width];
+    uint8_t bit = 1 << (y & 7);
+
+    switch (color)
+    {
+    case SSD1306_WHITE:
+        *cell |= bit;
+        break;
+    case SSD1306_BLACK:
+        *cell &= ~bit;
+        break;
+    case SSD1306_INVERSE:
+        *cell ^= bit;
+        break;
+    }
+}
+
+void Adafruit_SSD1306::startscrollright(uint8_t start, uint8_t stop)
+{
+    uint8_t scroll[] = {SSD1306_RIGHT_HORIZONTAL_SCROLL, 0x00, start, 0x00, stop, 0x00, 0xFF, SSD1306_ACTIVATE_SCROLL};
+
+    commandList(scroll, sizeof(scroll));
+    _scrolling = true;
+}
+
+void Adafruit_SSD1306::startscrollleft(uint8_t start, uint8_t stop)
+{
+    uint8_t scroll[] = {SSD1306_LEFT_HORIZONTAL_SCROLL, 0x00, start, 0x00, stop, 0x00, 0xFF, SSD1306_ACTIVATE_SCROLL};
+
+    commandList(scroll, sizeof(scroll));
+    _scrolling = true;
+}
+
+void Adafruit_SSD1306::stopscroll()
+{
+    ssd1306_command(SSD1306_DEACTIVATE_SCROLL);
+    _scrolling = false;
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c)
+{
+    commandList(&c, 1);
+}
+
+bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y)
+{
+    if (x < 0 || x >= _width || y < 0 || y >= _height)
+    {
+        return false;
+    }
+
+    return _buffer[x + (y / 8) * _width] & (1 << (y & 7));
+}
+
+uint8_t *Adafruit_SSD1306::getBuffer()
+{
+    return _buffer;
+}
+
+unsigned long Adafruit_SSD1306::Frames()
+{
+    return _frames;
+}
+
+bool Adafruit_SSD1306::Scrolling()
+{
+    return _scrolling;
+}
+
+// plain PBM of the framebuffer, what the next display() would show
+void Adafruit_SSD1306::WritePbm(FILE *file)
+{
+    fprintf(file, "P1\n%d %d\n", _width, _height);
+
+    for (int16_t y = 0; y < _height; y++)
+    {
+        for (int16_t x = 0; x < _width; x++)
+        {
+            fputc(getPixel(x, y) ? '1' : '0', file);
+        }
+
+        fputc('\n', file);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef NATIVE_EEPROM
+#define NATIVE_EEPROM
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define E2END 0x3FF // ATmega328P, 1 KB
+
+// In-memory EEPROM, erased to 0xFF like a new part.
+class EEPROMClass
+{
+private:
+    uint8_t _data[E2END + 1];
+public:
+    EEPROMClass()
+    {
+        memset(_data, 0xFF, sizeof(_data));
+    }
+
+    uint8_t read(int idx)
+    {
+        return _data[idx];
+    }
+
+    void write(int idx, uint8_t val)
+    {
+        _data[idx] = val;
+    }
+
+    void update(int idx, uint8_t val)
+    {
+        _data[idx] = val;
+    }
+
+    uint8_t &operator[](int idx)
+    {
+        return _data[idx];
+    }
+
+    uint16_t length()
+    {
+        return E2END + 1;
+    }
+
+    template <typename T> T &get(int idx, T &t)
+    {
+        memcpy(&t, &_data[idx], sizeof(T));
+        return t;
+    }
+
+    template <typename T> const T &put(int idx, const T &t)
+    {
+        memcpy(&_data[idx], &t, sizeof(T));
+        return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
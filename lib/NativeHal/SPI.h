@@ -0,0 +1,33 @@
+#ifndef NATIVE_SPI
+#define NATIVE_SPI
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+// Only here so the SPI includes resolve, no device on the host uses SPI.
+
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+    SPISettings() {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {}
+};
+
+class SPIClass
+{
+public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings settings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data) { return 0xFF; }
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,152 @@
+#include "WString.h"
+
+// Same allocation pattern as the AVR core: the buffer is exactly as large
+// as the longest content so far, and the numeric constructors go through
+// ltoa and dtostrf into a stack buffer first.
+
+char *dtostrf(double val, signed char width, unsigned char prec, char *sout)
+{
+    sprintf(sout, "%*.*f", width, prec, val);
+    return sout;
+}
+
+String::String(const char *cstr)
+{
+    if (cstr)
+    {
+        copy(cstr, strlen(cstr));
+    }
+}
+
+String::String(const String &value)
+{
+    *this = value;
+}
+
+String::String(String &&value)
+{
+    *this = static_cast<String &&>(value);
+}
+
+String::String(long value, unsigned char base)
+{
+    char buf[2 + 8 * sizeof(long)];
+
+    snprintf(buf, sizeof(buf), base == HEX ? "%lx" : "%ld", value);
+    *this = buf;
+}
+
+String::String(int value, unsigned char base)
+    : String((long)value, base)
+{
+}
+
+String::String(float value, unsigned char decimalPlaces)
+{
+    char buf[33];
+
+    *this = dtostrf(value, decimalPlaces + 2, decimalPlaces, buf);
+}
+
+String::~String()
+{
+    free(_buffer);
+}
+
+bool String::reserve(unsigned int size)
+{
+    if (_buffer && _capacity >= size)
+    {
+        return true;
+    }
+
+    char *grown = (char *)realloc(_buffer, size + 1);
+
+    if (grown == nullptr)
+    {
+        return false;
+    }
+
+    if (_buffer == nullptr)
+    {
+        grown[0] = '\0';
+    }
+
+    _buffer = grown;
+    _capacity = size;
+    return true;
+}
+
+String &String::copy(const char *cstr, unsigned int length)
+{
+    if (!reserve(length))
+    {
+        free(_buffer);
+        _buffer = nullptr;
+        _capacity = _len = 0;
+        return *this;
+    }
+
+    _len = length;
+    strcpy(_buffer, cstr);
+    return *this;
+}
+
+bool String::concat(const char *cstr, unsigned int length)
+{
+    if (length == 0)
+    {
+        return true;
+    }
+
+    if (!reserve(_len + length))
+    {
+        return false;
+    }
+
+    strcpy(_buffer + _len, cstr);
+    _len += length;
+    return true;
+}
+
+String &String::operator=(const String &rhs)
+{
+    if (this == &rhs)
+    {
+        return *this;
+    }
+
+    return copy(rhs.c_str(), rhs._len);
+}
+
+String &String::operator=(String &&rhs)
+{
+    if (this != &rhs)
+    {
+        free(_buffer);
+        _buffer = rhs._buffer;
+        _capacity = rhs._capacity;
+        _len = rhs._len;
+        rhs._buffer = nullptr;
+        rhs._capacity = rhs._len = 0;
+    }
+
+    return *this;
+}
+
+String &String::operator=(const char *cstr)
+{
+    return copy(cstr, strlen(cstr));
+}
+
+String &String::operator+=(const String &rhs)
+{
+    concat(rhs.c_str(), rhs._len);
+    return *this;
+}
+
+String &String::operator+=(const char *cstr)
+{
+    concat(cstr, strlen(cstr));
+    return *this;
+}
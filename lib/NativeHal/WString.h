@@ -0,0 +1,48 @@
+#ifndef NATIVE_WSTRING
+#define NATIVE_WSTRING
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+// The part of the AVR core's String the firmware used before TextBuffer,
+// kept so env:bench can measure that path. Grows its heap buffer the same
+// way, one realloc per concat past the capacity.
+class String
+{
+private:
+    char *_buffer = nullptr;
+    unsigned int _capacity = 0;
+    unsigned int _len = 0;
+
+    bool reserve(unsigned int size);
+    String &copy(const char *cstr, unsigned int length);
+    bool concat(const char *cstr, unsigned int length);
+public:
+    String(const char *cstr = "");
+    String(const String &value);
+    String(String &&value);
+    explicit String(long value, unsigned char base = DEC);
+    explicit String(int value, unsigned char base = DEC);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    ~String();
+
+    String &operator=(const String &rhs);
+    String &operator=(String &&rhs);
+    String &operator=(const char *cstr);
+    String &operator+=(const String &rhs);
+    String &operator+=(const char *cstr);
+
+    unsigned int length() const
+    {
+        return _len;
+    }
+
+    const char *c_str() const
+    {
+        return _buffer ? _buffer : "";
+    }
+};
+
+#endif
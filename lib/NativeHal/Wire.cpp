@@ -0,0 +1,210 @@
+#include "Wire.h"
+#include "native_hal.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+{
+    ResetStats();
+}
+
+int8_t TwoWire::slot(uint8_t address)
+{
+    for (uint8_t i = 0; i < _deviceCount; i++)
+    {
+        if (_addresses[i] == address)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// one transaction of the address byte plus bytes, -1 for a NACKed address
+void TwoWire::count(int8_t slot, bool read, uint8_t bytes)
+{
+    uint64_t nanos = ((uint64_t)(bytes + 1) * WIRE_BYTE_BITS + WIRE_FRAME_BITS) * 1000000000ULL / _clock;
+    WireStats *stats[] = {&_total, slot < 0 ? nullptr : &_stats[slot]};
+
+    for (WireStats *s : stats)
+    {
+        if (s == nullptr)
+        {
+            continue;
+        }
+
+        if (slot < 0)
+        {
+            s->nacks++;
+        }
+        else if (read)
+        {
+            s->reads++;
+            s->bytesRead += bytes;
+        }
+        else
+        {
+            s->writes++;
+            s->bytesWritten += bytes;
+        }
+
+        s->busNanos += nanos;
+    }
+
+    if (_timed)
+    {
+        Native.Advance(nanos / 1000);
+    }
+}
+
+void TwoWire::Attach(uint8_t address, WireDevice *device)
+{
+    Detach(address);
+
+    if (_deviceCount < WIRE_MAX_DEVICES)
+    {
+        _addresses[_deviceCount] = address;
+        _devices[_deviceCount] = device;
+        memset(&_stats[_deviceCount++], 0, sizeof(WireStats));
+    }
+}
+
+void TwoWire::Detach(uint8_t address)
+{
+    for (uint8_t i = 0; i < _deviceCount; i++)
+    {
+        if (_addresses[i] == address)
+        {
+            _deviceCount--;
+            _addresses[i] = _addresses[_deviceCount];
+            _devices[i] = _devices[_deviceCount];
+            _stats[i] = _stats[_deviceCount];
+            return;
+        }
+    }
+}
+
+uint32_t TwoWire::Clock()
+{
+    return _clock;
+}
+
+const WireStats &TwoWire::Stats()
+{
+    return _total;
+}
+
+WireStats TwoWire::Stats(uint8_t address)
+{
+    int8_t i = slot(address);
+    WireStats none;
+
+    memset(&none, 0, sizeof(none));
+    return i < 0 ? none : _stats[i];
+}
+
+void TwoWire::ResetStats()
+{
+    memset(&_total, 0, sizeof(_total));
+    memset(_stats, 0, sizeof(_stats));
+}
+
+// transfers advance the virtual clock by their bus time
+void TwoWire::Timed(bool timed)
+{
+    _timed = timed;
+}
+
+void TwoWire::begin()
+{
+}
+
+void TwoWire::end()
+{
+}
+
+void TwoWire::setClock(uint32_t clock)
+{
+    _clock = clock;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _txAddress = address;
+    _txLength = 0;
+    _transmitting = true;
+}
+
+// 0 on success, 2 for an address NACK, as in the AVR Wire library. Like
+// there, the TX buffer is emptied, a second call sends an empty write.
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+    int8_t target = slot(_txAddress);
+    uint8_t length = _txLength;
+
+    _transmitting = false;
+    _txLength = 0;
+    count(target, false, target < 0 ? 0 : length);
+
+    if (target < 0)
+    {
+        return 2;
+    }
+
+    _devices[target]->Receive(_tx, length);
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+    int8_t target = slot(address);
+
+    if (quantity > BUFFER_LENGTH)
+    {
+        quantity = BUFFER_LENGTH;
+    }
+
+    _rxIndex = 0;
+    _rxLength = target < 0 ? 0 : _devices[target]->Request(_rx, quantity);
+    count(target, true, target < 0 ? 0 : quantity);
+    return _rxLength;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (!_transmitting || _txLength >= BUFFER_LENGTH)
+    {
+        return 0;
+    }
+
+    _tx[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+    size_t n = 0;
+
+    while (n < quantity && write(data[n]))
+    {
+        n++;
+    }
+
+    return n;
+}
+
+int TwoWire::available()
+{
+    return _rxLength - _rxIndex;
+}
+
+int TwoWire::read()
+{
+    return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1;
+}
+
+int TwoWire::peek()
+{
+    return _rxIndex < _rxLength ? _rx[_rxIndex] : -1;
+}
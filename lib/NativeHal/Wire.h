@@ -0,0 +1,87 @@
+#ifndef NATIVE_WIRE
+#define NATIVE_WIRE
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define BUFFER_LENGTH 32 // same TX/RX limit as the AVR twi buffers
+#define WIRE_MAX_DEVICES 4
+#define WIRE_BYTE_BITS 9  // 8 data bits and the ACK
+#define WIRE_FRAME_BITS 2 // START and STOP
+
+// Bus traffic of one device or of the whole bus. busNanos is the time the
+// transfers take at the clock set when they ran, from the bit count alone.
+struct WireStats
+{
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t nacks;
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+    uint64_t busNanos;
+};
+
+// A device model on the fake bus. Receive() gets the bytes of a completed
+// write transaction, Request() fills the bytes of a read.
+class WireDevice
+{
+public:
+    virtual ~WireDevice() {}
+    virtual void Receive(const uint8_t *data, uint8_t length) = 0;
+    virtual uint8_t Request(uint8_t *data, uint8_t length) = 0;
+};
+
+// TwoWire on a virtual bus. Transactions to an address without an attached
+// device are NACKed the way the AVR driver reports them. Every transaction
+// is counted per device, Timed() also lets it take its bus time off the
+// virtual clock.
+class TwoWire
+{
+private:
+    uint8_t _addresses[WIRE_MAX_DEVICES];
+    WireDevice *_devices[WIRE_MAX_DEVICES];
+    WireStats _stats[WIRE_MAX_DEVICES];
+    WireStats _total;
+    uint8_t _deviceCount = 0;
+    bool _timed = false;
+    uint8_t _txAddress;
+    uint8_t _tx[BUFFER_LENGTH];
+    uint8_t _txLength = 0;
+    bool _transmitting = false;
+    uint8_t _rx[BUFFER_LENGTH];
+    uint8_t _rxLength = 0;
+    uint8_t _rxIndex = 0;
+    uint32_t _clock = 100000UL;
+
+    int8_t slot(uint8_t address);
+    void count(int8_t slot, bool read, uint8_t bytes);
+public:
+    TwoWire();
+    void Attach(uint8_t address, WireDevice *device);
+    void Detach(uint8_t address);
+    uint32_t Clock();
+    const WireStats &Stats();
+    WireStats Stats(uint8_t address);
+    void ResetStats();
+    void Timed(bool timed);
+
+    void begin();
+    void end();
+    void setClock(uint32_t clock);
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t quantity);
+    int available();
+    int read();
+    int peek();
+};
+
+extern TwoWire Wire;
+
+#endif
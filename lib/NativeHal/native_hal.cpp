@@ -0,0 +1,351 @@
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "native_hal.h"
+#include "EEPROM.h"
+#include "SPI.h"
+
+NativeHal Native;
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+SPIClass SPI;
+
+NativeHal::NativeHal()
+{
+    for (uint8_t pin = 0; pin < NATIVE_PINS; pin++)
+    {
+        // floating inputs read high, like the pulled-up button and nINT lines
+        _levels[pin] = HIGH;
+        _modes[pin] = INPUT;
+    }
+
+    for (uint8_t irq = 0; irq < NATIVE_INTERRUPTS; irq++)
+    {
+        _isr[irq] = nullptr;
+        _isrMode[irq] = CHANGE;
+    }
+
+    _tx = stdout;
+}
+
+uint64_t NativeHal::wallMicros()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+uint64_t NativeHal::Micros()
+{
+    if (_wallClock)
+    {
+        return _micros + wallMicros() - _wallStart;
+    }
+
+    return _micros;
+}
+
+void NativeHal::tick()
+{
+    uint64_t now = Micros();
+
+    for (uint8_t i = 0; i < _listenerCount; i++)
+    {
+        _listeners[i]->Tick(now);
+    }
+}
+
+void NativeHal::Advance(uint64_t us)
+{
+    if (_wallClock)
+    {
+        usleep(us);
+    }
+    else
+    {
+        _micros += us;
+    }
+
+    tick();
+}
+
+void NativeHal::SetTime(uint64_t us)
+{
+    _micros = us;
+    _wallStart = wallMicros();
+    tick();
+}
+
+void NativeHal::WallClock(bool enabled)
+{
+    if (enabled == _wallClock)
+    {
+        return;
+    }
+
+    // keep the clock continuous across the switch
+    _micros = Micros();
+    _wallStart = wallMicros();
+    _wallClock = enabled;
+}
+
+// gives the host CPU back between loop() passes when running in real time
+void NativeHal::Idle()
+{
+    if (_wallClock)
+    {
+        usleep(NATIVE_IDLE_MICROS);
+        tick();
+    }
+}
+
+void NativeHal::Listen(ClockListener *listener)
+{
+    if (_listenerCount < NATIVE_MAX_LISTENERS)
+    {
+        _listeners[_listenerCount++] = listener;
+    }
+}
+
+void NativeHal::PinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < NATIVE_PINS)
+    {
+        _modes[pin] = mode;
+    }
+}
+
+void NativeHal::raise(uint8_t pin, uint8_t from, uint8_t to)
+{
+    int irq = digitalPinToInterrupt(pin);
+
+    if (irq == NOT_AN_INTERRUPT || irq >= NATIVE_INTERRUPTS || _isr[irq] == nullptr || from == to)
+    {
+        return;
+    }
+
+    if (_isrMode[irq] == CHANGE || (_isrMode[irq] == FALLING && to == LOW) || (_isrMode[irq] == RISING && to == HIGH))
+    {
+        _isr[irq]();
+    }
+}
+
+// drives an input pin from outside, an edge runs the attached ISR right away
+void NativeHal::SetPin(uint8_t pin, uint8_t level)
+{
+    if (pin >= NATIVE_PINS)
+    {
+        return;
+    }
+
+    uint8_t from = _levels[pin];
+
+    _levels[pin] = level ? HIGH : LOW;
+    raise(pin, from, _levels[pin]);
+}
+
+uint8_t NativeHal::GetPin(uint8_t pin)
+{
+    return pin < NATIVE_PINS ? _levels[pin] : LOW;
+}
+
+void NativeHal::Attach(uint8_t interruptNum, void (*isr)(), int mode)
+{
+    if (interruptNum < NATIVE_INTERRUPTS)
+    {
+        _isr[interruptNum] = isr;
+        _isrMode[interruptNum] = mode;
+    }
+}
+
+void NativeHal::Detach(uint8_t interruptNum)
+{
+    if (interruptNum < NATIVE_INTERRUPTS)
+    {
+        _isr[interruptNum] = nullptr;
+    }
+}
+
+// queues one received byte, false when the RX buffer is full as on the AVR
+bool NativeHal::Type(uint8_t c)
+{
+    if ((uint8_t)(_rxHead - _rxTail) >= NATIVE_SERIAL_RX)
+    {
+        return false;
+    }
+
+    _rx[_rxHead++ & (NATIVE_SERIAL_RX - 1)] = c;
+    return true;
+}
+
+void NativeHal::Type(const char *text)
+{
+    while (*text && Type((uint8_t)*text))
+    {
+        text++;
+    }
+}
+
+// moves whatever is waiting on stdin into the RX buffer without blocking
+void NativeHal::ReadStdin()
+{
+    static bool nonBlocking = false;
+    uint8_t c;
+
+    if (!nonBlocking)
+    {
+        fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+        nonBlocking = true;
+    }
+
+    while ((uint8_t)(_rxHead - _rxTail) < NATIVE_SERIAL_RX && read(STDIN_FILENO, &c, 1) == 1)
+    {
+        Type(c);
+    }
+}
+
+int NativeHal::SerialAvailable()
+{
+    return (uint8_t)(_rxHead - _rxTail);
+}
+
+int NativeHal::SerialPeek()
+{
+    return _rxHead == _rxTail ? -1 : _rx[_rxTail & (NATIVE_SERIAL_RX - 1)];
+}
+
+int NativeHal::SerialRead()
+{
+    return _rxHead == _rxTail ? -1 : _rx[_rxTail++ & (NATIVE_SERIAL_RX - 1)];
+}
+
+// where Serial output goes, nullptr drops it
+void NativeHal::SerialOutput(FILE *file)
+{
+    _tx = file;
+}
+
+FILE *NativeHal::SerialOutput()
+{
+    return _tx;
+}
+
+// gets Serial output in addition to the FILE, nullptr to stop
+void NativeHal::SerialListen(SerialListener *listener)
+{
+    _serialListener = listener;
+}
+
+SerialListener *NativeHal::SerialListen()
+{
+    return _serialListener;
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(Native.Micros() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)Native.Micros();
+}
+
+void delay(unsigned long ms)
+{
+    Native.Advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    Native.Advance(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    Native.PinMode(pin, mode);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return Native.GetPin(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    Native.SetPin(pin, val);
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*isr)(), int mode)
+{
+    Native.Attach(interruptNum, isr, mode);
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+    Native.Detach(interruptNum);
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+}
+
+void HardwareSerial::end()
+{
+}
+
+int HardwareSerial::available()
+{
+    return Native.SerialAvailable();
+}
+
+int HardwareSerial::peek()
+{
+    return Native.SerialPeek();
+}
+
+int HardwareSerial::read()
+{
+    return Native.SerialRead();
+}
+
+void HardwareSerial::flush()
+{
+    if (Native.SerialOutput())
+    {
+        fflush(Native.SerialOutput());
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    if (Native.SerialOutput())
+    {
+        fputc(c, Native.SerialOutput());
+    }
+
+    if (Native.SerialListen())
+    {
+        Native.SerialListen()->Write(c);
+    }
+
+    return 1;
+}
+
+#if !defined(NATIVE_HAL_NO_MAIN) && !defined(PIO_UNIT_TESTING)
+// runs the firmware in real time, Serial is wired to stdin/stdout
+int main()
+{
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    Native.WallClock(true);
+    setup();
+
+    for (;;)
+    {
+        Native.ReadStdin();
+        loop();
+        Native.Idle();
+    }
+}
+#endif
@@ -0,0 +1,88 @@
+#ifndef NATIVE_HAL
+#define NATIVE_HAL
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define NATIVE_PINS 20       // D0-D13, A0-A5 of the nano
+#define NATIVE_INTERRUPTS 2  // INT0 on D2, INT1 on D3
+#define NATIVE_SERIAL_RX 64  // power of two, the AVR core's RX buffer size
+#define NATIVE_IDLE_MICROS 100
+#define NATIVE_MAX_LISTENERS 4
+
+// Hardware that changes on its own as time passes, like a sensor model
+// pulling its interrupt line. Tick() runs whenever the clock moved.
+class ClockListener
+{
+public:
+    virtual ~ClockListener() {}
+    virtual void Tick(uint64_t micros) = 0;
+};
+
+// Sees every byte the firmware writes to Serial, like a terminal would.
+class SerialListener
+{
+public:
+    virtual ~SerialListener() {}
+    virtual void Write(uint8_t c) = 0;
+};
+
+// Host side of the fake Arduino layer. millis()/micros(), digitalRead(),
+// attachInterrupt() and Serial read their state from here, harnesses and
+// the default main() drive it.
+// The clock is virtual and only moves on Advance() and delay(), so a run is
+// reproducible and can go faster than real time. WallClock() ties it to the
+// host clock instead, for running the firmware interactively.
+class NativeHal
+{
+private:
+    uint64_t _micros = 0;
+    bool _wallClock = false;
+    uint64_t _wallStart;
+    uint8_t _levels[NATIVE_PINS];
+    uint8_t _modes[NATIVE_PINS];
+    void (*_isr[NATIVE_INTERRUPTS])();
+    uint8_t _isrMode[NATIVE_INTERRUPTS];
+    uint8_t _rx[NATIVE_SERIAL_RX];
+    uint8_t _rxHead = 0;
+    uint8_t _rxTail = 0;
+    FILE *_tx;
+    SerialListener *_serialListener = nullptr;
+    ClockListener *_listeners[NATIVE_MAX_LISTENERS];
+    uint8_t _listenerCount = 0;
+
+    uint64_t wallMicros();
+    void tick();
+    void raise(uint8_t pin, uint8_t from, uint8_t to);
+public:
+    NativeHal();
+    uint64_t Micros();
+    void Advance(uint64_t us);
+    void SetTime(uint64_t us);
+    void WallClock(bool enabled);
+    void Idle();
+    void Listen(ClockListener *listener);
+
+    void PinMode(uint8_t pin, uint8_t mode);
+    void SetPin(uint8_t pin, uint8_t level);
+    uint8_t GetPin(uint8_t pin);
+    void Attach(uint8_t interruptNum, void (*isr)(), int mode);
+    void Detach(uint8_t interruptNum);
+
+    bool Type(uint8_t c);
+    void Type(const char *text);
+    void ReadStdin();
+    int SerialAvailable();
+    int SerialPeek();
+    int SerialRead();
+    void SerialOutput(FILE *file);
+    FILE *SerialOutput();
+    void SerialListen(SerialListener *listener);
+    SerialListener *SerialListen();
+};
+
+extern NativeHal Native;
+
+#endif
@@ -0,0 +1,185 @@
+#include "record_store.h"
+
+RecordStore::RecordStore(uint16_t start, uint16_t size)
+{
+    _start = start;
+    _slots = min(size / RECORD_SIZE, 255U);
+    _head = 0;
+    _nextSequence = 1;
+    _tags = 0;
+}
+
+uint8_t RecordStore::crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = 0;
+
+    // polynomial 0x07, the erased 0xFF pattern doesn't check out
+    while (length--)
+    {
+        crc ^= *data++;
+
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+bool RecordStore::readSlot(uint8_t slot, uint8_t *record)
+{
+    uint16_t address = _start + slot * RECORD_SIZE;
+
+    for (uint8_t i = 0; i < RECORD_SIZE; i++)
+    {
+        record[i] = EEPROM.read(address + i);
+    }
+
+    return record[0] != RECORD_TAG_EMPTY && crc8(record, RECORD_SIZE - 1) == record[RECORD_SIZE - 1];
+}
+
+void RecordStore::Begin()
+{
+    uint32_t newest = 0;
+    uint32_t latestSequence[RECORD_MAX_TAGS];
+    uint8_t record[RECORD_SIZE];
+
+    _tags = 0;
+    _head = 0;
+
+    for (uint8_t slot = 0; slot < _slots; slot++)
+    {
+        if (!readSlot(slot, record))
+        {
+            continue;
+        }
+
+        uint32_t sequence = (uint32_t)record[1] << 24 | (uint32_t)record[2] << 16 | (uint32_t)record[3] << 8 | record[4];
+        Latest *latest = find(record[0]);
+
+        if (latest == nullptr && _tags < RECORD_MAX_TAGS)
+        {
+            latest = &_latest[_tags];
+            latest->tag = record[0];
+            latestSequence[_tags++] = 0;
+        }
+
+        if (latest != nullptr && sequence > latestSequence[latest - _latest])
+        {
+            latestSequence[latest - _latest] = sequence;
+            latest->slot = slot;
+            latest->payload = (uint16_t)record[5] << 8 | record[6];
+        }
+
+        if (sequence >= newest)
+        {
+            newest = sequence;
+            _head = (slot + 1) % _slots;
+        }
+    }
+
+    _nextSequence = newest + 1;
+}
+
+RecordStore::Latest *RecordStore::find(uint8_t tag)
+{
+    for (uint8_t i = 0; i < _tags; i++)
+    {
+        if (_latest[i].tag == tag)
+        {
+            return &_latest[i];
+        }
+    }
+
+    return nullptr;
+}
+
+bool RecordStore::isLive(uint8_t slot)
+{
+    for (uint8_t i = 0; i < _tags; i++)
+    {
+        if (_latest[i].slot == slot)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool RecordStore::Read(uint8_t tag, uint16_t &payload)
+{
+    Latest *latest = find(tag);
+
+    if (latest == nullptr)
+    {
+        return false;
+    }
+
+    payload = latest->payload;
+    return true;
+}
+
+// false when the record didn't read back intact or there's no room for the tag
+bool RecordStore::Write(uint8_t tag, uint16_t payload)
+{
+    Latest *latest = find(tag);
+    uint8_t record[RECORD_SIZE];
+    uint8_t check[RECORD_SIZE];
+
+    if (latest != nullptr && latest->payload == payload)
+    {
+        return true; // nothing changed, spare the cells
+    }
+
+    if (latest == nullptr && (_tags == RECORD_MAX_TAGS || _tags >= _slots))
+    {
+        return false;
+    }
+
+    // never overwrite the newest record of a tag, it may be all that's left
+    while (isLive(_head))
+    {
+        _head = (_head + 1) % _slots;
+    }
+
+    record[0] = tag;
+    record[1] = _nextSequence >> 24;
+    record[2] = _nextSequence >> 16;
+    record[3] = _nextSequence >> 8;
+    record[4] = _nextSequence;
+    record[5] = payload >> 8;
+    record[6] = payload;
+    record[7] = crc8(record, RECORD_SIZE - 1);
+
+    uint16_t address = _start + _head * RECORD_SIZE;
+
+    // the slot reads as empty until the tag goes in last, so a torn write
+    // is skipped at Begin() instead of relying on the CRC to catch it
+    EEPROM.update(address, RECORD_TAG_EMPTY);
+
+    for (uint8_t i = 1; i < RECORD_SIZE; i++)
+    {
+        EEPROM.update(address + i, record[i]);
+    }
+
+    EEPROM.update(address, tag);
+
+    if (!readSlot(_head, check) || memcmp(record, check, RECORD_SIZE) != 0)
+    {
+        return false;
+    }
+
+    if (latest == nullptr)
+    {
+        latest = &_latest[_tags++];
+        latest->tag = tag;
+    }
+
+    latest->slot = _head;
+    latest->payload = payload;
+    _nextSequence++;
+    _head = (_head + 1) % _slots;
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef RECORD_STORE
+#define RECORD_STORE
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#include <EEPROM.h>
+
+#define RECORD_SIZE 8       // tag, 4 byte sequence, 2 byte payload, CRC8
+#define RECORD_MAX_TAGS 4   // distinct tags cached by Begin()
+#define RECORD_TAG_EMPTY 0xFF
+
+// Log-structured EEPROM store. Every write appends a record to the next
+// slot of a ring over the given area, so the cells wear evenly, and an
+// unchanged value isn't written at all. Records carry a sequence number
+// and a CRC8, the tag byte is committed last so a torn write is ignored
+// and the previous value stays current. Begin() scans the area once and caches
+// the newest record of each tag.
+class RecordStore
+{
+private:
+    struct Latest
+    {
+        uint8_t tag;
+        uint8_t slot;
+        uint16_t payload;
+    };
+
+    uint16_t _start;
+    uint8_t _slots;
+    uint8_t _head;
+    uint32_t _nextSequence;
+    Latest _latest[RECORD_MAX_TAGS];
+    uint8_t _tags;
+
+    static uint8_t crc8(const uint8_t *data, uint8_t length);
+    bool readSlot(uint8_t slot, uint8_t *record);
+    Latest *find(uint8_t tag);
+    bool isLive(uint8_t slot);
+public:
+    RecordStore(uint16_t start, uint16_t size);
+    void Begin();
+    bool Read(uint8_t tag, uint16_t &payload);
+    bool Write(uint8_t tag, uint16_t payload);
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler()
+{
+    memset(_slots, SCHEDULER_NONE, sizeof(_slots));
+    _count = 0;
+    _lastTick = millis();
+    _running = false;
+}
+
+TaskId Scheduler::Add(void (*callback)())
+{
+    if (_count >= SCHEDULER_MAX_TASKS)
+    {
+        return SCHEDULER_NONE;
+    }
+
+    Task &task = _tasks[_count];
+    task.callback = callback;
+    task.deadline = 0;
+    task.period = 0;
+    task.next = SCHEDULER_NONE;
+    task.prev = SCHEDULER_NONE;
+    task.armed = false;
+
+    return _count++;
+}
+
+void Scheduler::Arm(TaskId id, unsigned long delay, unsigned long period)
+{
+    if (id >= _count)
+    {
+        return;
+    }
+
+    // anything armed from a callback waits for the next tick, so a task
+    // re-arming itself with no delay can't spin inside Update()
+    if (_running && delay == 0)
+    {
+        delay = 1;
+    }
+
+    unsigned long deadline = millis() + delay;
+
+    // Update() already visited the slot of _lastTick, a deadline on it
+    // would wait for the wheel to come round again
+    if ((long)(deadline - _lastTick) <= 0)
+    {
+        deadline = _lastTick + 1;
+    }
+
+    Cancel(id);
+    _tasks[id].deadline = deadline;
+    _tasks[id].period = period;
+    _tasks[id].armed = true;
+    link(id);
+}
+
+void Scheduler::Cancel(TaskId id)
+{
+    if (id >= _count || !_tasks[id].armed)
+    {
+        return;
+    }
+
+    unlink(id);
+    _tasks[id].armed = false;
+}
+
+bool Scheduler::IsArmed(TaskId id)
+{
+    return id < _count && _tasks[id].armed;
+}
+
+void Scheduler::link(TaskId id)
+{
+    uint8_t slot = _tasks[id].deadline & (SCHEDULER_SLOTS - 1);
+
+    _tasks[id].prev = SCHEDULER_NONE;
+    _tasks[id].next = _slots[slot];
+
+    if (_slots[slot] != SCHEDULER_NONE)
+    {
+        _tasks[_slots[slot]].prev = id;
+    }
+
+    _slots[slot] = id;
+}
+
+void Scheduler::unlink(TaskId id)
+{
+    Task &task = _tasks[id];
+
+    if (task.prev != SCHEDULER_NONE)
+    {
+        _tasks[task.prev].next = task.next;
+    }
+    else
+    {
+        _slots[task.deadline & (SCHEDULER_SLOTS - 1)] = task.next;
+    }
+
+    if (task.next != SCHEDULER_NONE)
+    {
+        _tasks[task.next].prev = task.prev;
+    }
+
+    task.next = SCHEDULER_NONE;
+    task.prev = SCHEDULER_NONE;
+}
+
+bool Scheduler::runSlot(uint8_t slot, unsigned long now)
+{
+    for (uint8_t id = _slots[slot]; id != SCHEDULER_NONE; id = _tasks[id].next)
+    {
+        Task &task = _tasks[id];
+
+        // tasks further out than one revolution share the slot, skip them
+        if ((long)(now - task.deadline) < 0)
+        {
+            continue;
+        }
+
+        unlink(id);
+
+        if (task.period != 0)
+        {
+            task.deadline += task.period;
+
+            // fell more than a period behind, don't fire a burst to catch up
+            if ((long)(now - task.deadline) >= 0)
+            {
+                task.deadline = now + task.period;
+            }
+
+            link(id);
+        }
+        else
+        {
+            task.armed = false;
+        }
+
+        task.callback();
+        return true; // the callback may have changed this slot's list
+    }
+
+    return false;
+}
+
+void Scheduler::Update()
+{
+    unsigned long now = millis();
+    unsigned long elapsed = now - _lastTick;
+
+    if (elapsed == 0)
+    {
+        return;
+    }
+
+    if (elapsed > SCHEDULER_SLOTS)
+    {
+        elapsed = SCHEDULER_SLOTS;
+    }
+
+    _running = true;
+
+    for (unsigned long tick = now - elapsed + 1; elapsed > 0; tick++, elapsed--)
+    {
+        uint8_t slot = tick & (SCHEDULER_SLOTS - 1);
+
+        while (runSlot(slot, now))
+        {
+        }
+    }
+
+    _running = false;
+    _lastTick = now;
+}
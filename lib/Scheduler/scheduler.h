@@ -0,0 +1,50 @@
+#ifndef SCHEDULER
+#define SCHEDULER
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define SCHEDULER_MAX_TASKS 10
+#define SCHEDULER_SLOTS 16 // wheel size, power of two, 1 ms per slot
+#define SCHEDULER_NONE 0xFF
+
+typedef uint8_t TaskId;
+
+// Hashed timer wheel with a fixed task table. Tasks hang off the slot of
+// their deadline in a doubly linked list, so arming and cancelling are O(1)
+// and Update() only looks at the slots for the milliseconds that passed.
+// Deadlines are compared with wrap-safe differences, millis() rollover is fine.
+class Scheduler
+{
+private:
+    struct Task
+    {
+        void (*callback)();
+        unsigned long deadline;
+        unsigned long period;
+        uint8_t next;
+        uint8_t prev;
+        bool armed;
+    };
+
+    Task _tasks[SCHEDULER_MAX_TASKS];
+    uint8_t _slots[SCHEDULER_SLOTS];
+    uint8_t _count;
+    unsigned long _lastTick;
+    bool _running;
+
+    void link(TaskId id);
+    void unlink(TaskId id);
+    bool runSlot(uint8_t slot, unsigned long now);
+public:
+    Scheduler();
+    TaskId Add(void (*callback)());
+    void Arm(TaskId id, unsigned long delay, unsigned long period = 0);
+    void Cancel(TaskId id);
+    bool IsArmed(TaskId id);
+    void Update();
+};
+
+#endif
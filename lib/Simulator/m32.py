@@ -0,0 +1,5 @@
+# env:sim32, builds and links for i386 so unsigned long is 32 bits like
+# on the AVR. -m32 in build_flags would only reach the compiler
+Import("env")
+
+env.Append(CCFLAGS=["-m32"], LINKFLAGS=["-m32"])
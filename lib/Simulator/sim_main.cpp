@@ -0,0 +1,146 @@
+#include <time.h>
+#include "simulator.h"
+#include "environment.h"
+#include "bme280_model.h"
+#include "ccs811_model.h"
+
+#define MILLIS_WRAP 4294967296ULL // 2^32, 49.7 days
+
+static void usage()
+{
+    fputs("usage: program [--trace FILE | --seed N] [--script FILE] [--eeprom FILE]\n"
+          "               [--start TIME] [--duration TIME] [--speed X]\n"
+          "  --trace     CSV of seconds,temperature_c,humidity_pct,pressure_hpa,eco2_ppm,tvoc_ppb\n"
+          "  --seed      synthetic day/occupancy air instead of a trace (default 1)\n"
+          "  --script    button presses, Serial input and expected output, see simulator.h\n"
+          "  --eeprom    EEPROM image loaded at power-on and saved at the end, for power cycles\n"
+          "  --start     millis() at power-on (default 0)\n"
+          "  --duration  device time to run (default 1:00:00:00, a day)\n"
+          "  --speed     times real time, 0 runs as fast as possible (default 0)\n"
+          "TIME is [[[D:]H:]M:]S[.mmm]\n",
+          stderr);
+}
+
+// the whole board: models on the bus, the firmware's setup()/loop() and
+// the script. Exits 1 when an expect failed, 2 on bad arguments or files.
+int main(int argc, char **argv)
+{
+    const char *tracePath = nullptr;
+    const char *scriptPath = nullptr;
+    const char *eepromPath = nullptr;
+    uint32_t seed = 1;
+    uint64_t start = 0;
+    uint64_t duration = 86400000ULL;
+    float speed = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok = value != nullptr;
+
+        if (ok && strcmp(argv[i], "--trace") == 0)
+        {
+            tracePath = value;
+        }
+        else if (ok && strcmp(argv[i], "--seed") == 0)
+        {
+            seed = strtoul(value, nullptr, 10);
+        }
+        else if (ok && strcmp(argv[i], "--script") == 0)
+        {
+            scriptPath = value;
+        }
+        else if (ok && strcmp(argv[i], "--eeprom") == 0)
+        {
+            eepromPath = value;
+        }
+        else if (ok && strcmp(argv[i], "--start") == 0)
+        {
+            ok = Simulator::ParseTime(value, start);
+        }
+        else if (ok && strcmp(argv[i], "--duration") == 0)
+        {
+            ok = Simulator::ParseTime(value, duration);
+        }
+        else if (ok && strcmp(argv[i], "--speed") == 0)
+        {
+            speed = strtof(value, nullptr);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            usage();
+            return 2;
+        }
+
+        i++;
+    }
+
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    Native.SetTime(start * 1000);
+
+    TraceEnvironment trace(Native.Micros());
+    SyntheticEnvironment synthetic(seed);
+    EnvironmentSource *air = &synthetic;
+
+    if (tracePath != nullptr)
+    {
+        if (!trace.Load(tracePath))
+        {
+            fprintf(stderr, "sim: can't read a trace from %s\n", tracePath);
+            return 2;
+        }
+
+        air = &trace;
+    }
+
+    Bme280Model bme(air);
+    Ccs811Model ccs(air, SIM_GAS_INT_PIN);
+    Ssd1306Model oled;
+    Simulator sim(&oled);
+
+    Wire.Attach(SIM_BME_ADDRESS, &bme);
+    Wire.Attach(SIM_CCS_ADDRESS, &ccs);
+    Wire.Attach(SIM_OLED_ADDRESS, &oled);
+    Native.Listen(&bme);
+    Native.Listen(&ccs);
+
+    if ((scriptPath != nullptr && !sim.LoadScript(scriptPath)) || (eepromPath != nullptr && !sim.LoadEeprom(eepromPath)))
+    {
+        return 2;
+    }
+
+    // on a 64-bit host millis() keeps counting where the AVR wraps to 0,
+    // a run that should cover the wrap would pass without exercising it
+    if (sizeof(unsigned long) > 4 && start + duration >= MILLIS_WRAP)
+    {
+        fputs("sim: unsigned long is 64 bits here, millis() won't wrap at 49.7 days; use env:sim32\n", stderr);
+        return 2;
+    }
+
+    struct timespec wallStart;
+    struct timespec wallEnd;
+
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    sim.Run(duration, speed);
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+
+    if (eepromPath != nullptr && !sim.SaveEeprom(eepromPath))
+    {
+        return 2;
+    }
+
+    double seconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+    WireStats bus = Wire.Stats();
+
+    fputs("sim: ", stderr);
+    Simulator::PrintTime(stderr, duration);
+    fprintf(stderr, " in %.1f s (%.0fx), %u Serial lines, %u I2C writes, %u reads, %u NACKs, CCS811 baseline %04X, %u expect(s) failed\n",
+            seconds, seconds > 0 ? duration / 1000.0 / seconds : 0.0, sim.Lines(), bus.writes, bus.reads, bus.nacks, ccs.Baseline(), sim.Failures());
+
+    return sim.Failures() ? 1 : 0;
+}
@@ -0,0 +1,402 @@
+#include <time.h>
+#include <unistd.h>
+#include <ctype.h>
+#include "simulator.h"
+#include "EEPROM.h"
+
+Simulator::Simulator(Ssd1306Model *oled)
+{
+    _oled = oled;
+}
+
+// [[[D:]H:]M:]S[.mmm], each field may be any size
+bool Simulator::ParseTime(const char *text, uint64_t &millis)
+{
+    static const uint64_t scale[] = {1000ULL, 60000ULL, 3600000ULL, 86400000ULL};
+    uint64_t fields[4];
+    uint8_t count = 0;
+    uint64_t fraction = 0;
+    const char *p = text;
+
+    for (;;)
+    {
+        char *end;
+
+        if (!isdigit((unsigned char)*p) || count == 4)
+        {
+            return false;
+        }
+
+        fields[count++] = strtoull(p, &end, 10);
+        p = end;
+
+        if (*p != ':')
+        {
+            break;
+        }
+
+        p++;
+    }
+
+    if (*p == '.')
+    {
+        uint64_t digit = 100;
+
+        for (p++; isdigit((unsigned char)*p); p++, digit /= 10)
+        {
+            fraction += (*p - '0') * digit;
+        }
+    }
+
+    if (*p != '\0')
+    {
+        return false;
+    }
+
+    millis = fraction;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        millis += fields[i] * scale[count - 1 - i];
+    }
+
+    return true;
+}
+
+void Simulator::PrintTime(FILE *file, uint64_t millis)
+{
+    fprintf(file, "%llud %02u:%02u:%02u.%03u", (unsigned long long)(millis / 86400000ULL), (unsigned)(millis / 3600000ULL % 24),
+            (unsigned)(millis / 60000ULL % 60), (unsigned)(millis / 1000ULL % 60), (unsigned)(millis % 1000));
+}
+
+// keeps the steps in time order, same-time steps in the order added
+bool Simulator::add(uint64_t at, Action action, const char *text)
+{
+    if (_count == SIM_MAX_STEPS)
+    {
+        return false;
+    }
+
+    uint16_t i = _count++;
+
+    while (i > 0 && _steps[i - 1].at > at)
+    {
+        _steps[i] = _steps[i - 1];
+        i--;
+    }
+
+    _steps[i].at = at;
+    _steps[i].action = action;
+    strncpy(_steps[i].text, text, SIM_TEXT - 1);
+    _steps[i].text[SIM_TEXT - 1] = '\0';
+    return true;
+}
+
+bool Simulator::LoadScript(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[SIM_LINE];
+    uint16_t number = 0;
+    bool ok = true;
+
+    if (file == nullptr)
+    {
+        fprintf(stderr, "sim: can't open %s\n", path);
+        return false;
+    }
+
+    while (ok && fgets(line, sizeof(line), file))
+    {
+        char time[32];
+        char action[16];
+        int consumed = 0;
+        uint64_t at;
+
+        number++;
+        line[strcspn(line, "#\r\n")] = '\0';
+
+        if (sscanf(line, " %31s %15s %n", time, action, &consumed) < 2)
+        {
+            // blank and comment lines
+            if (sscanf(line, " %31s", time) == 1)
+            {
+                ok = false;
+            }
+        }
+        else
+        {
+            const char *text = line + consumed;
+
+            if (!ParseTime(time, at))
+            {
+                ok = false;
+            }
+            else if (strcmp(action, "press") == 0)
+            {
+                ok = add(at, ActionDown) && add(at + SIM_PRESS_MILLIS, ActionUp);
+            }
+            else if (strcmp(action, "long") == 0)
+            {
+                ok = add(at, ActionDown) && add(at + SIM_LONG_PRESS_MILLIS, ActionUp);
+            }
+            else if (strcmp(action, "double") == 0)
+            {
+                uint64_t second = at + SIM_PRESS_MILLIS + SIM_DOUBLE_GAP_MILLIS;
+
+                ok = add(at, ActionDown) && add(at + SIM_PRESS_MILLIS, ActionUp) && add(second, ActionDown) && add(second + SIM_PRESS_MILLIS, ActionUp);
+            }
+            else if (strcmp(action, "down") == 0)
+            {
+                ok = add(at, ActionDown);
+            }
+            else if (strcmp(action, "up") == 0)
+            {
+                ok = add(at, ActionUp);
+            }
+            else if (strcmp(action, "type") == 0 && *text)
+            {
+                ok = add(at, ActionType, text);
+            }
+            else if (strcmp(action, "expect") == 0 && *text)
+            {
+                ok = add(at, ActionExpect, text);
+            }
+            else if (strcmp(action, "snap") == 0 && *text)
+            {
+                ok = add(at, ActionSnap, text);
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+    }
+
+    fclose(file);
+
+    if (!ok)
+    {
+        fprintf(stderr, "sim: %s:%u: bad step or script too long\n", path, number);
+        return false;
+    }
+
+    // trailing blanks of the step text
+    for (uint16_t i = 0; i < _count; i++)
+    {
+        size_t length = strlen(_steps[i].text);
+
+        while (length > 0 && isspace((unsigned char)_steps[i].text[length - 1]))
+        {
+            _steps[i].text[--length] = '\0';
+        }
+    }
+
+    nextExpected();
+    return true;
+}
+
+// a missing file is a new part, erased to 0xFF
+bool Simulator::LoadEeprom(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == nullptr)
+    {
+        return true;
+    }
+
+    for (uint16_t i = 0; i < EEPROM.length(); i++)
+    {
+        int c = fgetc(file);
+
+        if (c == EOF)
+        {
+            break;
+        }
+
+        EEPROM[i] = c;
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool Simulator::SaveEeprom(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+
+    if (file == nullptr)
+    {
+        fprintf(stderr, "sim: can't write %s\n", path);
+        return false;
+    }
+
+    for (uint16_t i = 0; i < EEPROM.length(); i++)
+    {
+        fputc(EEPROM[i], file);
+    }
+
+    return fclose(file) == 0;
+}
+
+// the text the next expect step waits for
+void Simulator::nextExpected()
+{
+    _expected = nullptr;
+    _seen = false;
+
+    for (uint16_t i = _next; i < _count; i++)
+    {
+        if (_steps[i].action == ActionExpect)
+        {
+            _expected = _steps[i].text;
+            return;
+        }
+    }
+}
+
+void Simulator::check(const char *line)
+{
+    if (_expected != nullptr && strstr(line, _expected) != nullptr)
+    {
+        _seen = true;
+    }
+}
+
+void Simulator::stamp(FILE *file)
+{
+    fputc('[', file);
+    PrintTime(file, (Native.Micros() - _origin) / 1000);
+    fputs("] ", file);
+}
+
+void Simulator::run(const Step &step)
+{
+    switch (step.action)
+    {
+    case ActionDown:
+        Native.SetPin(SIM_BUTTON_PIN, LOW);
+        break;
+    case ActionUp:
+        Native.SetPin(SIM_BUTTON_PIN, HIGH);
+        break;
+    case ActionType:
+        Native.Type(step.text);
+        break;
+    case ActionExpect:
+        // the line being written counts too
+        _line[_lineLength] = '\0';
+        check(_line);
+
+        if (!_seen)
+        {
+            _failures++;
+            fputs("sim: ", stderr);
+            PrintTime(stderr, step.at);
+            fprintf(stderr, ": expected \"%s\"\n", step.text);
+        }
+
+        nextExpected();
+        break;
+    case ActionSnap:
+    {
+        FILE *file = fopen(step.text, "w");
+
+        if (file == nullptr)
+        {
+            fprintf(stderr, "sim: can't write %s\n", step.text);
+            _failures++;
+            break;
+        }
+
+        _oled->WritePbm(file, SIM_OLED_WIDTH, SIM_OLED_HEIGHT);
+        fclose(file);
+        break;
+    }
+    }
+}
+
+// powers the board on at the current device time and runs it
+void Simulator::Run(uint64_t durationMillis, float speed)
+{
+    struct timespec wallStart;
+    struct timespec wall;
+
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    _origin = Native.Micros();
+    Native.SerialOutput(nullptr);
+    Native.SerialListen(this);
+    setup();
+
+    for (uint64_t elapsed = 0; elapsed < durationMillis; elapsed++)
+    {
+        while (_next < _count && _steps[_next].at <= elapsed)
+        {
+            // _next moves first, an expect then looks for the following one
+            run(_steps[_next++]);
+        }
+
+        loop();
+        Native.Advance(SIM_STEP_MICROS);
+
+        if (speed > 0 && elapsed % SIM_PACE_MILLIS == 0)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &wall);
+
+            int64_t wallMicros = (int64_t)(wall.tv_sec - wallStart.tv_sec) * 1000000 + (wall.tv_nsec - wallStart.tv_nsec) / 1000;
+            int64_t ahead = (int64_t)(elapsed * 1000 / speed) - wallMicros;
+
+            if (ahead > 0)
+            {
+                usleep(ahead);
+            }
+        }
+    }
+
+    // steps scheduled for the very end
+    while (_next < _count && _steps[_next].at <= durationMillis)
+    {
+        run(_steps[_next++]);
+    }
+
+    Native.SerialListen(nullptr);
+}
+
+void Simulator::Write(uint8_t c)
+{
+    if (c == '\r')
+    {
+        return;
+    }
+
+    if (_lineStart)
+    {
+        stamp(stdout);
+        _lineStart = false;
+    }
+
+    fputc(c, stdout);
+
+    if (c == '\n')
+    {
+        _line[_lineLength] = '\0';
+        check(_line);
+        _lineLength = 0;
+        _lineStart = true;
+        _lines++;
+    }
+    else if (_lineLength < SIM_LINE - 1)
+    {
+        _line[_lineLength++] = c;
+    }
+}
+
+uint16_t Simulator::Failures()
+{
+    return _failures;
+}
+
+uint32_t Simulator::Lines()
+{
+    return _lines;
+}
@@ -0,0 +1,88 @@
+#ifndef SIMULATOR
+#define SIMULATOR
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#include "native_hal.h"
+#include "ssd1306_model.h"
+
+#define SIM_BUTTON_PIN 3  // BTN_PIN in src/main.h
+#define SIM_GAS_INT_PIN 2 // CCS811_INT_PIN
+#define SIM_BME_ADDRESS 0x76
+#define SIM_CCS_ADDRESS 0x5A
+#define SIM_OLED_ADDRESS 0x3C
+#define SIM_OLED_WIDTH 128
+#define SIM_OLED_HEIGHT 32
+#define SIM_STEP_MICROS 1000 // loop() runs once per device millisecond
+#define SIM_PACE_MILLIS 10   // device time between checks against the wall clock
+#define SIM_MAX_STEPS 256
+#define SIM_TEXT 64
+#define SIM_LINE 128
+#define SIM_PRESS_MILLIS 200 // held past DEBOUNCE
+#define SIM_LONG_PRESS_MILLIS 2500 // past LONG_PRESS
+#define SIM_DOUBLE_GAP_MILLIS 150  // inside DOUBLE_PRESS_GAP
+
+// Runs setup()/loop() on the virtual clock, one loop() per device
+// millisecond, as fast as the host allows or paced to a multiple of real
+// time. A script drives the button and Serial input and checks the output:
+//   TIME press|long|double|down|up
+//   TIME type TEXT       queue TEXT on Serial RX
+//   TIME expect TEXT     a Serial line since the previous expect had TEXT
+//   TIME snap FILE       save what the OLED shows as a PBM
+// TIME counts from power-on as [[[D:]H:]M:]S[.mmm], # starts a comment.
+// Serial output goes to stdout, each line stamped with the time since
+// power-on.
+class Simulator : public SerialListener
+{
+private:
+    enum Action
+    {
+        ActionDown,
+        ActionUp,
+        ActionType,
+        ActionExpect,
+        ActionSnap
+    };
+
+    struct Step
+    {
+        uint64_t at; // ms since power-on
+        Action action;
+        char text[SIM_TEXT];
+    };
+
+    Step _steps[SIM_MAX_STEPS];
+    uint16_t _count = 0;
+    uint16_t _next = 0;
+    Ssd1306Model *_oled;
+    uint64_t _origin = 0;
+    char _line[SIM_LINE];
+    uint8_t _lineLength = 0;
+    bool _lineStart = true;
+    const char *_expected = nullptr;
+    bool _seen = false;
+    uint16_t _failures = 0;
+    uint32_t _lines = 0;
+
+    bool add(uint64_t at, Action action, const char *text = "");
+    void nextExpected();
+    void check(const char *line);
+    void run(const Step &step);
+    void stamp(FILE *file);
+public:
+    Simulator(Ssd1306Model *oled);
+    static bool ParseTime(const char *text, uint64_t &millis);
+    static void PrintTime(FILE *file, uint64_t millis);
+    bool LoadScript(const char *path);
+    bool LoadEeprom(const char *path);
+    bool SaveEeprom(const char *path);
+    void Run(uint64_t durationMillis, float speed);
+    void Write(uint8_t c);
+    uint16_t Failures();
+    uint32_t Lines();
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE
+#define SPSC_QUEUE
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+// Fixed-capacity ring for handing items from one producer (usually an ISR)
+// to one consumer (loop()). Indices are free-running bytes, a single byte
+// load/store is atomic on AVR, so neither side has to disable interrupts.
+// The acquire/release pairs order the slot access against the index update.
+template <typename T, uint8_t N>
+class SpscQueue
+{
+    static_assert(N != 0 && (N & (N - 1)) == 0 && N <= 128, "N must be a power of two up to 128");
+
+private:
+    T _items[N];
+    uint8_t _head = 0; // written by the producer only
+    uint8_t _tail = 0; // written by the consumer only
+
+public:
+    // producer side, false when full
+    bool Push(const T &item)
+    {
+        uint8_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+
+        if ((uint8_t)(head - tail) == N)
+        {
+            return false;
+        }
+
+        _items[head & (N - 1)] = item;
+        __atomic_store_n(&_head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // consumer side, false when empty
+    bool Pop(T &item)
+    {
+        uint8_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        uint8_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+
+        if (head == tail)
+        {
+            return false;
+        }
+
+        item = _items[tail & (N - 1)];
+        __atomic_store_n(&_tail, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool IsEmpty() const
+    {
+        return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+    }
+
+    uint8_t Capacity() const
+    {
+        return N;
+    }
+};
+
+#endif
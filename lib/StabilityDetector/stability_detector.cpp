@@ -0,0 +1,85 @@
+#include "stability_detector.h"
+
+StabilityDetector::StabilityDetector(uint8_t shift, uint16_t maxDeviation, uint8_t maxPercent, uint16_t minSamples, uint16_t holdSamples)
+{
+    _shift = shift;
+    _maxDeviation = maxDeviation;
+    _maxPercent = maxPercent;
+    _minSamples = minSamples;
+    _holdSamples = holdSamples;
+    Reset();
+}
+
+void StabilityDetector::Reset()
+{
+    _mean = 0;
+    _variance = 0;
+    _samples = 0;
+    _stableFor = 0;
+}
+
+void StabilityDetector::Add(uint16_t value)
+{
+    int32_t x = (int32_t)value << 4;
+
+    if (_samples == 0)
+    {
+        _mean = x;
+    }
+    else
+    {
+        int32_t delta = x - _mean;
+        int32_t deviation = delta / 16;
+        uint32_t square = (uint32_t)(deviation * deviation) << 4;
+
+        _mean += delta / (1L << _shift);
+
+        if (square > _variance)
+        {
+            _variance += (square - _variance) >> _shift;
+        }
+        else
+        {
+            _variance -= (_variance - square) >> _shift;
+        }
+    }
+
+    if (_samples < 0xFFFF)
+    {
+        _samples++;
+    }
+
+    uint32_t limit = (uint32_t)Mean() * _maxPercent / 100;
+
+    if (limit < _maxDeviation)
+    {
+        limit = _maxDeviation;
+    }
+
+    if (_samples >= _minSamples && _variance <= (limit * limit) << 4)
+    {
+        if (_stableFor < 0xFFFF)
+        {
+            _stableFor++;
+        }
+    }
+    else
+    {
+        _stableFor = 0;
+    }
+}
+
+bool StabilityDetector::IsStable()
+{
+    return _stableFor >= _holdSamples;
+}
+
+uint16_t StabilityDetector::Mean()
+{
+    return (_mean + 8) >> 4;
+}
+
+uint32_t StabilityDetector::Variance()
+{
+    return (_variance + 8) >> 4;
+}
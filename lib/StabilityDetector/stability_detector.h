@@ -0,0 +1,35 @@
+#ifndef STABILITY_DETECTOR
+#define STABILITY_DETECTOR
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+// Streaming settle detector. Keeps an exponentially weighted mean and
+// variance (window about 2^shift samples) and reports stable once the
+// standard deviation stayed within max(maxDeviation, maxPercent of the
+// mean) for holdSamples in a row, after at least minSamples. A signal
+// still drifting keeps lagging its own mean, so slopes count as variance.
+class StabilityDetector
+{
+private:
+    int32_t _mean;      // 1/16 units
+    uint32_t _variance; // 1/16 units squared
+    uint16_t _samples;
+    uint16_t _stableFor;
+    uint8_t _shift;
+    uint16_t _maxDeviation;
+    uint8_t _maxPercent;
+    uint16_t _minSamples;
+    uint16_t _holdSamples;
+public:
+    StabilityDetector(uint8_t shift, uint16_t maxDeviation, uint8_t maxPercent, uint16_t minSamples, uint16_t holdSamples);
+    void Reset();
+    void Add(uint16_t value);
+    bool IsStable();
+    uint16_t Mean();
+    uint32_t Variance();
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "text_buffer.h"
+#include <stdarg.h>
+
+#if !defined(__AVR__) && !defined(vsnprintf_P)
+#define vsnprintf_P vsnprintf
+#endif
+
+TextBuffer::TextBuffer(char *buffer, size_t capacity)
+{
+    _buffer = buffer;
+    _capacity = capacity;
+    Clear();
+}
+
+size_t TextBuffer::write(uint8_t c)
+{
+    if (_length + 1 >= _capacity)
+    {
+        return 0;
+    }
+
+    _buffer[_length++] = c;
+    _buffer[_length] = '\0';
+    return 1;
+}
+
+size_t TextBuffer::write(const uint8_t *buffer, size_t size)
+{
+    size_t room = _capacity - _length - 1;
+
+    if (size > room)
+    {
+        size = room;
+    }
+
+    memcpy(_buffer + _length, buffer, size);
+    _length += size;
+    _buffer[_length] = '\0';
+    return size;
+}
+
+void TextBuffer::Clear()
+{
+    _length = 0;
+    _buffer[0] = '\0';
+}
+
+size_t TextBuffer::Assign(const char *text)
+{
+    Clear();
+    return print(text);
+}
+
+size_t TextBuffer::Assign(const __FlashStringHelper *text)
+{
+    Clear();
+    return print(text);
+}
+
+size_t TextBuffer::Assign(const TextBuffer &other)
+{
+    Clear();
+    return write((const uint8_t *)other._buffer, other._length);
+}
+
+size_t TextBuffer::advance(int written)
+{
+    size_t room = _capacity - _length - 1;
+
+    if (written < 0)
+    {
+        _buffer[_length] = '\0';
+        return 0;
+    }
+
+    // vsnprintf reports the untruncated length
+    if ((size_t)written > room)
+    {
+        written = room;
+    }
+
+    _length += written;
+    return written;
+}
+
+size_t TextBuffer::Format(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(_buffer + _length, _capacity - _length, fmt, args);
+    va_end(args);
+
+    return advance(written);
+}
+
+size_t TextBuffer::Format(const __FlashStringHelper *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf_P(_buffer + _length, _capacity - _length, (const char *)fmt, args);
+    va_end(args);
+
+    return advance(written);
+}
+
+bool TextBuffer::Equals(const TextBuffer &other) const
+{
+    return _length == other._length && memcmp(_buffer, other._buffer, _length) == 0;
+}
+
+// FNV-1a, lets callers remember a text without keeping a copy of it
+uint32_t TextBuffer::Hash() const
+{
+    uint32_t hash = 2166136261UL;
+
+    for (size_t i = 0; i < _length; i++)
+    {
+        hash = (hash ^ (uint8_t)_buffer[i]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+size_t TextBuffer::Length() const
+{
+    return _length;
+}
+
+size_t TextBuffer::Capacity() const
+{
+    return _capacity - 1;
+}
+
+const char *TextBuffer::c_str() const
+{
+    return _buffer;
+}
@@ -0,0 +1,52 @@
+#ifndef TEXT_BUFFER
+#define TEXT_BUFFER
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+// Fixed-capacity, null-terminated text that never touches the heap.
+// Everything Print offers (numbers, HEX, F() literals) appends to it;
+// text past the capacity is dropped.
+class TextBuffer : public Print
+{
+private:
+    char *_buffer;
+    size_t _capacity;
+    size_t _length;
+
+    size_t advance(int written);
+public:
+    TextBuffer(char *buffer, size_t capacity);
+    TextBuffer(const TextBuffer &) = delete;
+    TextBuffer &operator=(const TextBuffer &) = delete;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+
+    void Clear();
+    size_t Assign(const char *text);
+    size_t Assign(const __FlashStringHelper *text);
+    size_t Assign(const TextBuffer &other);
+    size_t Format(const char *fmt, ...);
+    size_t Format(const __FlashStringHelper *fmt, ...);
+    bool Equals(const TextBuffer &other) const;
+    uint32_t Hash() const;
+    size_t Length() const;
+    size_t Capacity() const;
+    const char *c_str() const;
+};
+
+// TextBuffer with its storage inline, for globals and stack buffers.
+template <size_t N>
+class StaticText : public TextBuffer
+{
+private:
+    char _storage[N];
+public:
+    StaticText() : TextBuffer(_storage, N) {}
+};
+
+#endif
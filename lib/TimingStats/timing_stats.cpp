@@ -0,0 +1,81 @@
+#include "timing_stats.h"
+
+TimingStats::TimingStats()
+{
+    Reset();
+}
+
+void TimingStats::Reset()
+{
+    _sum = 0;
+    _samples = 0;
+    _max = 0;
+    memset(_bins, 0, sizeof(_bins));
+}
+
+void TimingStats::Add(unsigned long micros)
+{
+    uint16_t value = micros > TIMING_MAX_MICROS ? TIMING_MAX_MICROS : micros;
+    uint16_t rest = value >> TIMING_FIRST_SHIFT;
+    uint8_t bin = 0;
+
+    while (rest > 0 && bin < TIMING_BINS - 1)
+    {
+        rest >>= 1;
+        bin++;
+    }
+
+    if (_bins[bin] == 0xFF)
+    {
+        // rounding up keeps rare slow passes visible, they matter most
+        for (uint8_t i = 0; i < TIMING_BINS; i++)
+        {
+            _bins[i] = (_bins[i] + 1) >> 1;
+        }
+    }
+
+    _bins[bin]++;
+
+    if (_samples == TIMING_MAX_SAMPLES)
+    {
+        _sum >>= 1;
+        _samples >>= 1;
+    }
+
+    _sum += value;
+    _samples++;
+
+    if (value > _max)
+    {
+        _max = value;
+    }
+}
+
+// samples behind the mean, halved now and then
+uint16_t TimingStats::Samples()
+{
+    return _samples;
+}
+
+uint16_t TimingStats::Mean()
+{
+    return _samples ? _sum / _samples : 0;
+}
+
+// saturates at TIMING_MAX_MICROS
+uint16_t TimingStats::Max()
+{
+    return _max;
+}
+
+// relative counts, see the class comment
+uint8_t TimingStats::Bin(uint8_t bin)
+{
+    return bin < TIMING_BINS ? _bins[bin] : 0;
+}
+
+// exclusive upper limit of a bin in us, 0 for the open last bin
+uint16_t TimingStats::BinLimit(uint8_t bin)
+{
+    return bin < TIMING_BINS - 1 ? 1U << (TIMING_FIRST_SHIFT + bin) : 0;
+}
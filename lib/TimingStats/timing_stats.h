@@ -0,0 +1,38 @@
+#ifndef TIMING_STATS
+#define TIMING_STATS
+
+#ifndef ARD
+#define ARD
+#include <Arduino.h>
+#endif
+
+#define TIMING_BINS 8
+#define TIMING_FIRST_SHIFT 8      // bin 0 is under 2^8 us
+#define TIMING_MAX_SAMPLES 0x8000 // sum and samples halve here
+#define TIMING_MAX_MICROS 0xFFFF  // longer durations count as this
+
+// Running duration stats of one code path in 16 bytes: max, mean and a
+// log2 histogram in microseconds. Bin 0 is under 256 us, every bin doubles
+// the limit and the last one takes everything from 16 ms on. A full bin
+// halves the whole histogram, a bin that was hit stays at 1 or more. The
+// mean halves its sum and sample count the same way, so both keep their
+// shape over long runs and lean towards recent samples.
+class TimingStats
+{
+private:
+    uint32_t _sum;
+    uint16_t _samples;
+    uint16_t _max;
+    uint8_t _bins[TIMING_BINS];
+public:
+    TimingStats();
+    void Reset();
+    void Add(unsigned long micros);
+    uint16_t Samples();
+    uint16_t Mean();
+    uint16_t Max();
+    uint8_t Bin(uint8_t bin);
+    static uint16_t BinLimit(uint8_t bin);
+};
+
+#endif
@@ -7,163 +7,434 @@
 void setup()
 {
   Serial.begin(9600);
+  records.Begin();
 
   // Display Init
   if (!display.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS))
   {
-    Serial.println("SSD1306 allocation failed");
+    Serial.println(F("SSD1306 allocation failed"));
     for (;;)
       ; // Don't proceed, loop forever
   }
 
-  display.display();
-  delay(2000); // Pause for 2 seconds
-
   display.clearDisplay();
   display.setTextSize(textSize);
   display.setTextWrap(false);
   display.setTextColor(SSD1306_WHITE);
   displayX = display.width();
+  invalidateDisplay();
 
-  // CCS811 Init
-  while (CCS811.begin() != 0)
+  // btn init
+  modeBtn.OnPress(onPress);
+  modeBtn.OnLongPress(onLongPress);
+  modeBtn.OnDoublePress(onDoublePress);
+  // BTN_PIN 3 is INT1, the button queues its own edges
+  modeBtn.AttachInterrupt();
+
+  // task init
+  sensorTask = scheduler.Add(PROFILED(ProbeSensor, updateSensorReading));
+  displayTask = scheduler.Add(PROFILED(ProbeDisplay, updateDisplay));
+  timeTask = scheduler.Add(PROFILED(ProbeTime, updateTime));
+  calibrationTask = scheduler.Add(stepCalibration);
+  calibrationTimeoutTask = scheduler.Add(calibrationTimeout);
+  historyTask = scheduler.Add(recordHistory);
+  serialTask = scheduler.Add(handleSerial);
+  hourTask = scheduler.Add(countHour);
+  bmeBootTask = scheduler.Add(bootBme);
+  ccsBootTask = scheduler.Add(bootCcs);
+
+  // ids are handed out in order, the last one is SCHEDULER_NONE if any is
+  if (ccsBootTask == SCHEDULER_NONE)
   {
-    Serial.println("failed to init chip, please check if the chip connection is fine");
-    delay(1000);
+    Serial.println(F("Scheduler full, raise SCHEDULER_MAX_TASKS"));
+    for (;;)
+      ;
   }
 
-  // BME Init
-  while (bme.begin() != BME::eStatusOK)
-  {
-    Serial.println("bme begin faild");
-    printLastOperateStatus(bme.lastOperateStatus);
-    delay(2000);
-  }
+  // sensors come up in the background, the loop runs with whatever is up
+  scheduler.Arm(bmeBootTask, 0);
+  scheduler.Arm(ccsBootTask, 0);
 
-  // btn init
-  modeBtn.OnPress(onPress);
-  modeBtn.OnLongPress(onLongPress);
+  scheduler.Arm(displayTask, 0, DISPLAY_INTERVAL);
+  scheduler.Arm(timeTask, SECOND_INTERVAL, SECOND_INTERVAL);
+  scheduler.Arm(historyTask, HISTORY_INTERVAL, HISTORY_INTERVAL);
+  scheduler.Arm(serialTask, SERIAL_INTERVAL, SERIAL_INTERVAL);
+  scheduler.Arm(hourTask, HOUR_INTERVAL, HOUR_INTERVAL);
 
   // Program init
   setMode(Temperature);
+
+#if defined(MAIN_DEBUG) && defined(__AVR__)
+  Serial.print(F("Free RAM: "));
+  Serial.println(freeRam());
+#endif
+}
+
+#ifdef __AVR__
+// bytes between the heap, framebuffer included, and the stack
+int freeRam()
+{
+  extern int __heap_start, *__brkval;
+  int top;
+  return (int)&top - (__brkval == 0 ? (int)&__heap_start : (int)__brkval);
 }
+#endif
 
 void loop()
 {
+#ifdef LOOP_PROFILE
+  unsigned long loopStart = micros();
+#endif
+
   // loop updates
-  updateSensorReading();
-  updateDisplay();
+  handleEvents();
+  scheduler.Update();
+
+#ifdef LOOP_PROFILE
+  unsigned long buttonStart = micros();
+  modeBtn.Update();
+  timings[ProbeButton].Add(micros() - buttonStart);
+  timings[ProbeLoop].Add(micros() - loopStart);
+#else
   modeBtn.Update();
-  updateTime();
+#endif
 }
 
-void restoreBaseline()
+bool restoreBaseline()
 {
-  /* uint16_t eepromValue = readEEPROM();
-  displayMode = Static;
-  display.setTextSize(1);
-  readout = String("Using saved baseline: \r\n") + String(eepromValue, HEX);
-  updateDisplay();
-  delay(GENERAL_DELAY);
-  display.setTextSize(TEXT_SIZE);
+  uint16_t savedBaseline;
 
-  baseline = eepromValue;
-  CCS811.writeBaseLine(baseline); */
+  records.Read(RECORD_TAG_HOURS, poweredHours);
+  baselineSaved = records.Read(RECORD_TAG_BASELINE, savedBaseline) && records.Read(RECORD_TAG_BASELINE_HOUR, baselineHour);
+
+  // ages count powered hours, time spent switched off isn't known
+  if (!baselineSaved || (uint16_t)(poweredHours - baselineHour) > BASELINE_AGE_MAX)
+  {
+#ifdef MAIN_DEBUG
+    Serial.println(F("Cold start"));
+#endif
+    return false;
+  }
+
+#ifdef MAIN_DEBUG
+  Serial.print(F("Using saved baseline: "));
+  Serial.println(savedBaseline, HEX);
+#endif
+
+  baseline = savedBaseline;
+  CCS811.writeBaseLine(baseline);
+  return true;
 }
 
-void updateSensorReading()
+void bootBme()
 {
-  unsigned long now = millis();
-  int nowHours = now / 1000 / 60 / 60;
+  BME::eStatus_t status = bmeState == DeviceStarting ? bme.beginPoll() : bme.beginStart();
+
+  advanceBoot(bmeState, bmeStarted, bmeRetry, bmeBootTask, status == BME::eStatusOK, status == BME::eStatusBusy);
+
+  if (bmeState == DeviceUp)
+  {
+    // the data registers hold the reset value until the first conversion
+    scheduler.Arm(sensorTask, BME_CONVERSION_TIME, MEASUREMENT_INTERVAL);
+  }
+  else if (bmeState == DeviceDown)
+  {
+    Serial.println(F("bme begin faild"));
+    printLastOperateStatus(bme.lastOperateStatus);
+  }
+}
+
+void bootCcs()
+{
+  int status = ccsState == DeviceStarting ? CCS811.beginPoll() : CCS811.beginStart();
+
+  advanceBoot(ccsState, ccsStarted, ccsRetry, ccsBootTask, status == ERR_OK, status == ERR_BUSY);
+
+  if (ccsState == DeviceUp)
+  {
+    startGasSensor();
+  }
+  else if (ccsState == DeviceDown)
+  {
+    Serial.println(F("failed to init chip, please check if the chip connection is fine"));
+  }
+}
+
+// polls a starting sensor every BOOT_POLL_INTERVAL, a start that fails or
+// takes longer than BOOT_START_TIMEOUT is retried with a growing backoff
+void advanceBoot(DeviceState &state, unsigned long &started, uint16_t &retry, TaskId task, bool ready, bool busy)
+{
+  if (ready)
+  {
+    state = DeviceUp;
+    retry = BOOT_RETRY_MIN;
+    return;
+  }
+
+  if (state == DeviceDown && busy)
+  {
+    state = DeviceStarting;
+    started = millis();
+  }
 
-  if (mode != Calibrate && now - lastMeasurement > MEASUREMENT_INTERVAL)
+  if (state == DeviceStarting && millis() - started < BOOT_START_TIMEOUT)
   {
-    readout = String();
+    scheduler.Arm(task, BOOT_POLL_INTERVAL);
+    return;
+  }
+
+  state = DeviceDown;
+  scheduler.Arm(task, retry);
+  retry = retry >= BOOT_RETRY_MAX / 2 ? BOOT_RETRY_MAX : retry * 2;
+}
+
+void startGasSensor()
+{
+  // the driver starts in the 250 ms raw-only mode, the algorithm results
+  // are only updated from the 1 s mode on
+#ifdef CCS811_INT_PIN
+  pinMode(CCS811_INT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(CCS811_INT_PIN), onGasReady, FALLING);
+#ifdef CO2_THRESHOLD_ALERT
+  CCS811.setThresholds(CO2_LOW_TO_MED, CO2_MED_TO_HIGH, CO2_HYSTERESIS);
+  CCS811.setMeasurementMode(CCS811.eCycle_1s, 1, 1);
+#else
+  CCS811.setMeasurementMode(CCS811.eCycle_1s, 0, 1);
+#endif
+
+  // nINT may already be low from an earlier frame, no edge would follow.
+  // Read it here, the ISRs are the only producers on the event queue
+  if (digitalRead(CCS811_INT_PIN) == LOW)
+  {
+    readGas();
+  }
+#else
+  CCS811.setMeasurementMode(CCS811.eCycle_1s);
+#endif
+
+  // warm start, a fresh saved baseline makes the readings usable right away
+  baselineUpdated = restoreBaseline();
+
+  // bootBme() already started the readings unless the BME280 is down
+  if (!scheduler.IsArmed(sensorTask))
+  {
+    scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+  }
+}
+
+bool usesGas(ModeEnum modeEnum)
+{
+  return modeEnum == CO2 || modeEnum == VOC || modeEnum == BaselineAge;
+}
+
+bool sensorsUp(ModeEnum modeEnum)
+{
+  return usesGas(modeEnum) ? ccsState == DeviceUp : bmeState == DeviceUp;
+}
+
+// history and aggregates only take complete, settled samples
+bool channelsReady()
+{
+  return bmeState == DeviceUp && ccsState == DeviceUp && baselineUpdated && gas.dataReady;
+}
+
+bool warmedUp()
+{
+  return minute >= MIN_TIME_FOR_CALIBRATION || (voltageStability.IsStable() && co2Stability.IsStable());
+}
+
+bool persistBaseline()
+{
+  baseline = CCS811.readBaseLine();
+
+  // unchanged values aren't rewritten, the hour goes last so a failed
+  // baseline write never looks fresh
+  if (!records.Write(RECORD_TAG_BASELINE, baseline) || !records.Write(RECORD_TAG_BASELINE_HOUR, poweredHours))
+  {
+    return false;
+  }
+
+  baselineHour = poweredHours;
+  baselineSaved = true;
+  return true;
+}
+
+void countHour()
+{
+  poweredHours++;
+  records.Write(RECORD_TAG_HOURS, poweredHours);
+
+  // keep the saved baseline as fresh as the sensor's own, once it settled
+  if (baselineUpdated && mode != Calibrate)
+  {
+    persistBaseline();
+  }
+}
+
+void updateSensorReading()
+{
+  if (mode != Calibrate)
+  {
+    if (ccsState == DeviceUp)
+    {
+#ifdef GAS_POLLING
+      readGas();
+#else
+      if (digitalRead(CCS811_INT_PIN) == LOW)
+      {
+        readGas();
+      }
+#endif
+
+      // cold start is over, the sensor settled on a baseline of its own
+      if (!baselineUpdated && warmedUp())
+      {
+        baselineUpdated = true;
+      }
+
+#ifdef CO2_THRESHOLD_ALERT
+      // nINT only reports crossings, one during warm-up was ignored and a
+      // warm start may begin above a threshold
+      if (!co2BandValid && gas.dataReady)
+      {
+        updateCo2Band(gas.eCO2);
+      }
+#endif
+    }
+
     /* #ifdef MAIN_DEBUG
-    Serial.print("displayX: ");
+    Serial.print(F("displayX: "));
     Serial.println(displayX);
-    Serial.print("displayMinX: ");
+    Serial.print(F("displayMinX: "));
     Serial.println(displayMinX);
-    Serial.print("displayMode: ");
+    Serial.print(F("displayMode: "));
     Serial.println(displayMode);
     #endif */
 
-    lastMeasurement = now;
-
-    if (minute >= MIN_TIME_FOR_CALIBRATION && !baselineUpdated)
+#ifdef LOOP_PROFILE
+    if (mode == Diagnostics)
     {
-      if (CCS811.checkDataReady())
-      {
-        CCS811.getCO2PPM();
-        CCS811.getTVOCPPB();
-      }
-
-      restoreBaseline();
-      baselineUpdated = true;      
+      readout.Clear();
+      showTimings();
     }
-    else if (minute < MIN_TIME_FOR_CALIBRATION && !baselineUpdated)
+    else
+#endif
+    if (!sensorsUp(mode))
+    {
+      readout.Assign(F("Sensor offline, retrying..."));
+    }
+    else if (usesGas(mode) && !baselineUpdated)
     {
-      readout = String("Waiting ") + String(MIN_TIME_FOR_CALIBRATION - minute) + String(" minute(s) ") + String("for resistance to stabilize...");
+      readout.Assign(F("Waiting up to "));
+      readout.print(MIN_TIME_FOR_CALIBRATION - minute);
+      readout.print(F(" minute(s) for resistance to stabilize..."));
     }
     else
     {
-      if (CCS811.checkDataReady())
+      if (!usesGas(mode) || gas.dataReady)
       {
-        float tempC = bme.getTemperature();
-        float hum = bme.getHumidity();
+        BME::sSampleFixed_t sample;
+        memset(&sample, 0, sizeof(sample));
+
+        if (bmeState == DeviceUp)
+        {
+          sample = bme.readSampleFixed();
+
+          if (bme.lastOperateStatus == BME::eStatusBusy)
+          {
+            return; // no conversion yet, keep the last readout
+          }
+        }
+
+        // cleared only with a sample in hand, so a busy BME keeps the text
+        readout.Clear();
+
+        // Q22.10 %RH to centi-%RH, rounded
+        int32_t humCenti = (int32_t)((sample.humidity * 100 + 512) >> 10);
+        int32_t values[ChannelCount];
+
+        if (channelsReady())
+        {
+          readChannels(sample, values);
+          aggregates.Add(values, millis());
+        }
+
+        if (statsView != StatsOff && formatStatsReading(readout, mode))
+        {
+          return;
+        }
 
         switch (mode)
         {
         case Temperature:
           /* #ifdef MAIN_DEBUG
-        Serial.print("Temp: ");
-        Serial.print(tempC);
-        Serial.println("C");
+        Serial.print(F("Temp: "));
+        Serial.print(sample.temperature);
+        Serial.println(F("C"));
         #endif */
-          readout = formatSensorReading("Temp", (tempC * 9 / 5) + 32, "F");
+          formatSensorReading(readout, F("Temp"), centiCelsiusToFahrenheit(sample.temperature), 2, READOUT_DECIMALS, F("F"));
           break;
         case Pressure:
-          readout = formatSensorReading("Pressure", bme.getPressure() / 100, "MB");
+          formatSensorReading(readout, F("Pressure"), sample.pressure, 2, 0, F("MB"));
           break;
         case Humidity:
-          readout = formatSensorReading("Humidity", hum, "%");
+          formatSensorReading(readout, F("Humidity"), humCenti, 2, READOUT_DECIMALS, F("%"));
           break;
         case Altitude:
-          readout = formatSensorReading("Altitude", bme.calAltitude(SEA_LEVEL_PRESSURE, bme.getPressure()), "M");
+          formatSensorReading(readout, F("Altitude"), bme.calAltitudeFixed(SEA_LEVEL_PRESSURE, sample.pressure), 2, READOUT_DECIMALS, F("M"));
           break;
         case CO2:
-          CCS811.setInTempHum(tempC, hum);
-          readout = formatSensorReading("CO2", CCS811.getCO2PPM(), "PPM");
+          if (bmeState == DeviceUp)
+          {
+            CCS811.setInTempHum(sample.temperature / 100.0f, humCenti / 100.0f);
+          }
+
+          formatSensorReading(readout, F("CO2"), gas.eCO2, 0, 0, F("PPM"));
           break;
         case VOC:
-          CCS811.setInTempHum(tempC, hum);
-          readout = formatSensorReading("TVOC", CCS811.getTVOCPPB(), "PPB");
+          if (bmeState == DeviceUp)
+          {
+            CCS811.setInTempHum(sample.temperature / 100.0f, humCenti / 100.0f);
+          }
+
+          formatSensorReading(readout, F("TVOC"), gas.eTVOC, 0, 0, F("PPB"));
           break;
         case BaselineAge:
 
-          if (nowHours - baselineAge > BASELINE_AGE_MAX)
+          if (!baselineSaved || (uint16_t)(poweredHours - baselineHour) > BASELINE_AGE_MAX)
           {
-            readout = "Please calibrate sensor...";
+            readout.Assign(F("Please calibrate sensor..."));
           }
           else
           {
 #ifdef MAIN_DEBUG
-            readout = formatSensorReading("Baseline", String(CCS811.readBaseLine(), HEX), "");
+            readout.Assign(F("Baseline: "));
+            readout.print(CCS811.readBaseLine(), HEX);
 #else
-            readout = formatSensorReading("BAge", nowHours - baselineAge, "HR(S)");
+            formatSensorReading(readout, F("BAge"), (uint16_t)(poweredHours - baselineHour), 0, 0, F("HR(S)"));
 #endif
           }
 
           break;
         case Calibrate:
+#ifdef LOOP_PROFILE
+        case Diagnostics:
+#endif
           break;
         }
+      }
+      else
+      {
+        readout.Clear(); // blank until the first gas frame
+      }
+    }
 
 #ifdef MAIN_DEBUG
-        Serial.println(readout);
-#endif
-      }
+    if (readout.Length() > 0)
+    {
+      Serial.println(readout.c_str());
     }
+#endif
   }
 }
 
@@ -174,7 +445,7 @@ void updateStaticDisplay()
 
 void updateScrollDisplay()
 {
-  displayMinX = -(PX_PER_CHAR * TEXT_SIZE) * readout.length();
+  displayMinX = -(PX_PER_CHAR * TEXT_SIZE) * readout.Length();
 
   if (--displayX < displayMinX)
   {
@@ -187,9 +458,55 @@ void updateBlinkDisplay()
   updateStaticDisplay();
 }
 
-void updateDisplay()
+bool fitsHardwareScroll(const TextBuffer &v)
 {
+  return v.Length() * PX_PER_CHAR * textSize <= SCREEN_WIDTH;
+}
+
+void updateHardwareScroll()
+{
+  if (hardwareScrolling && renderedValid && readout.Hash() == renderedHash)
+  {
+    return; // the controller keeps rotating display RAM on its own
+  }
+
+  stopHardwareScroll();
+  displayX = X_CUR;
   writeText(readout);
+  display.startscrollleft(0, SCREEN_HEIGHT / 8 - 1);
+  hardwareScrolling = true;
+}
+
+void stopHardwareScroll()
+{
+  if (!hardwareScrolling)
+  {
+    return;
+  }
+
+  display.stopscroll();
+  hardwareScrolling = false;
+  // scrolling shifted display RAM, it no longer matches the framebuffer
+  invalidateDisplay();
+}
+
+void updateDisplay()
+{
+  if (displayMode == Scroll && fitsHardwareScroll(readout))
+  {
+    updateHardwareScroll();
+    return;
+  }
+
+  stopHardwareScroll();
+  if (displayMode == Blink && blinkHidden())
+  {
+    writeText(blankText);
+  }
+  else
+  {
+    writeText(readout);
+  }
 
   switch (displayMode)
   {
@@ -207,193 +524,615 @@ void updateDisplay()
 
 void updateTime()
 {
-  unsigned long now = millis();
-  int nowSecond = now / 1000;
+  second++;
+  updateWaiting();
 
-  if (nowSecond - lastSecond >= 1)
+  if (second >= 60)
   {
-    second++;
-    lastSecond = nowSecond;
-    if (onSecondTickCallbacks != nullptr)
-    {
-      for (size_t i = 0; i < sizeof(onSecondTickCallbacks); i++)
-      {
-        onSecondTickCallbacks[i]();
-      }
-    }
+    minute++;
+    second = 0;
+  }
+}
 
-    updateWaiting();
+void displayBaselineCalibrationAndTime()
+{
+  readout.Assign(F("Calibrating"));
+  readout.print(waiting);
+  readout.print(F("\r\n"));
+  readout.Format(F("%02d:%02d Baseline %x"), minute, second, (unsigned int)CCS811.readBaseLine());
+#ifdef MAIN_DEBUG
+  Serial.println(readout.c_str());
+#endif
+}
 
-    if (second == 60)
-    {
-      minute++;
-    }
+void saveBaselineToEEPROM()
+{
+  // verified by reading the records back
+  if (persistBaseline())
+  {
+#ifdef MAIN_DEBUG
+    Serial.println(baseline, HEX);
+#endif
+    baselineUpdated = true;
+    showCalibrationResult(F("Saved!"));
+  }
+  else
+  {
+    showCalibrationResult(F("Saving to EEPROM failed!"));
   }
+}
 
-  if (second >= 60)
+void onPress()
+{
+  if (mode != Calibrate)
   {
-    second = 0;
+    incrementMode();
+    scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+    return;
+  }
+
+  switch (calibrationState)
+  {
+  case CalibrationRunning:
+    enterCalibrationState(CalibrationWaitingForData);
+    break;
+  case CalibrationShowingResult:
+    enterCalibrationState(CalibrationIdle);
+    break;
+  default:
+    break;
   }
 }
 
-void displayBaselineCalibrationAndTime()
+void onLongPress()
 {
-  String baselineValue = String(CCS811.readBaseLine(), HEX);
-  const char fmt[] = "%02d:%02d %s %s";
-  char baselineChar[baselineValue.length()];
-  baselineValue.toCharArray(baselineChar, baselineValue.length());
+  if (mode == Calibrate)
+  {
+    if (calibrationState == CalibrationShowingResult)
+    {
+      enterCalibrationState(CalibrationIdle);
+    }
+    else
+    {
+      showCalibrationResult(F("Canceled!"));
+    }
 
-  char *formatted = (char *)malloc(sizeof(char) * (strlen(fmt) + strlen(baselineChar)));
+    return;
+  }
 
-  sprintf(formatted, fmt, minute, second, "Baseline", baselineChar);
+  if (ccsState != DeviceUp)
+  {
+    return;
+  }
 
-  readout = "Calibrating";
-  readout += String(waiting);
-  readout += "\r\n";
-  readout += String(formatted);
+  minute = 0;
+  second = 0;
 #ifdef MAIN_DEBUG
-  Serial.println(readout);
+  Serial.println(F("Calibrating baseline"));
 #endif
-  updateDisplay();
-  display.setTextSize(1);
 
-  free(formatted);
+  setMode(Calibrate);
+  enterCalibrationState(CalibrationRunning);
 }
 
-uint16_t readEEPROM()
+void enterCalibrationState(CalibrationState state)
 {
-#ifdef MAIN_DEBUG
-  Serial.println("Getting EEPROM value...");
+  calibrationState = state;
+
+  switch (state)
+  {
+  case CalibrationRunning:
+    textSize = 1;
+    display.setTextSize(textSize);
+    invalidateDisplay();
+    displayBaselineCalibrationAndTime();
+    scheduler.Arm(timeTask, SECOND_INTERVAL, SECOND_INTERVAL);
+    // one tick behind the clock so the screen shows the updated time
+    scheduler.Arm(calibrationTask, SECOND_INTERVAL + 1, SECOND_INTERVAL);
+    scheduler.Arm(calibrationTimeoutTask, MAX_TIME_FOR_CALIBRATION * 60000UL);
+    break;
+  case CalibrationWaitingForData:
+    calibrationGasFrames = gasFrames;
+    scheduler.Arm(calibrationTask, 0, DATA_POLL_INTERVAL);
+    scheduler.Arm(calibrationTimeoutTask, DATA_WAIT_TIMEOUT);
+    break;
+  case CalibrationShowingResult:
+    scheduler.Cancel(calibrationTask);
+    scheduler.Arm(calibrationTimeoutTask, GENERAL_DELAY);
+    break;
+  case CalibrationIdle:
+    scheduler.Cancel(calibrationTask);
+    scheduler.Cancel(calibrationTimeoutTask);
+    setMode(static_cast<ModeEnum>(0));
+    textSize = TEXT_SIZE;
+    display.setTextSize(textSize);
+    invalidateDisplay();
+    minute = 0;
+    second = 0;
+    scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+    break;
+  }
+}
+
+void stepCalibration()
+{
+  switch (calibrationState)
+  {
+  case CalibrationRunning:
+    displayBaselineCalibrationAndTime();
+    break;
+  case CalibrationWaitingForData:
+#ifdef GAS_POLLING
+    readGas();
 #endif
-  uint16_t baseline = (EEPROM.read(EEPROM_ADDR)) * 256;
+
+    if (gasFrames != calibrationGasFrames)
+    {
+      saveBaselineToEEPROM();
+    }
 #ifdef MAIN_DEBUG
-  Serial.print("EEPROM highByte: ");
-  Serial.println(baseline, HEX);
+    else
+    {
+      Serial.println(F("Waiting for sensor..."));
+    }
 #endif
+    break;
+  default:
+    break;
+  }
+}
 
-  uint8_t low = EEPROM.read(EEPROM_ADDR + 1);
-  baseline += low;
+void calibrationTimeout()
+{
+  switch (calibrationState)
+  {
+  case CalibrationRunning:
+    enterCalibrationState(CalibrationWaitingForData);
+    break;
+  case CalibrationWaitingForData:
+    showCalibrationResult(F("Failed to read baseline!"));
+    break;
+  case CalibrationShowingResult:
+    enterCalibrationState(CalibrationIdle);
+    break;
+  default:
+    break;
+  }
+}
 
-#ifdef MAIN_DEBUG
-  Serial.print("EEPROM lowByte: ");
-  Serial.println(low, HEX);
+void handleEvents()
+{
+  Event event;
 
-  Serial.print("EEPROM fullByte: ");
-  Serial.println(baseline, HEX);
+  while (events.Pop(event))
+  {
+    switch (event.type)
+    {
+    case EventGasReady:
+      // only touch the bus once nINT reported a new frame or band change,
+      // reading the result registers releases the pin again
+      readGas();
+#ifdef CO2_THRESHOLD_ALERT
+      updateCo2Band(gas.eCO2);
 #endif
+      break;
+    }
+  }
+}
 
-  return baseline;
+// ISRs only, the queue takes a single producer
+void pushEvent(EventType type, uint8_t level)
+{
+  Event event;
+  event.type = type;
+  event.level = level;
+  event.time = millis();
+
+  // a full queue drops the event, a missed nINT is picked up by
+  // updateSensorReading(), the pin stays low
+  events.Push(event);
 }
 
-void saveBaselineToEEPROM()
+void readGas()
 {
-  int secondsWaited = 0;
+  DFRobot_CCS811::sResult_t result = CCS811.readResult();
 
-  while (!CCS811.checkDataReady())
+  if (result.dataReady)
   {
-#ifdef MAIN_DEBUG
-    Serial.println("Waiting for sensor...");
+#ifndef GAS_POLLING
+    // the first frame after boot shouldn't wait for the next measurement,
+    // polled frames are read by the tasks that show them
+    if (!gas.dataReady)
+    {
+      scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+    }
 #endif
 
-    delay(1000);
-    secondsWaited++;
+    gas = result;
+    gasFrames++;
 
-    if (secondsWaited >= 30)
+    if (!baselineUpdated)
     {
-      readout = String("Failed to read baseline!");
-#ifdef MAIN_DEBUG
-      Serial.println(readout);
-#endif
-
-      updateDisplay();
-      delay(GENERAL_DELAY);
-      return;
+      voltageStability.Add(gas.voltage);
+      co2Stability.Add(gas.eCO2);
     }
+
+#ifndef CO2_THRESHOLD_ALERT
+    updateCo2Band(gas.eCO2);
+#endif
   }
+}
 
-  if (CCS811.checkDataReady())
+void updateCo2Band(uint16_t eCO2)
+{
+  // warm-up readings mean nothing, the band is checked once it's over
+  if (!baselineUpdated)
   {
-#ifdef MAIN_DEBUG
-    Serial.println(baseline, HEX);
-#endif
+    return;
+  }
+
+  Co2Band band = co2Band;
+  co2BandValid = true;
 
-    baseline = CCS811.readBaseLine();
-    EEPROM.write(EEPROM_ADDR, highByte(baseline));
-    EEPROM.write(EEPROM_ADDR + 1, lowByte(baseline));
+  // step up as soon as a threshold is reached, only step back down once
+  // eCO2 dropped below it by the hysteresis. The CCS811 threshold
+  // interrupt wants that margin on both sides, so it fires at or after
+  // the step seen here
+  if (eCO2 >= CO2_MED_TO_HIGH)
+  {
+    band = Co2High;
+  }
+  else if (eCO2 >= CO2_LOW_TO_MED)
+  {
+    band = band == Co2High && eCO2 >= CO2_MED_TO_HIGH - CO2_HYSTERESIS ? Co2High : Co2Medium;
+  }
+  else if (band == Co2Low || eCO2 < CO2_LOW_TO_MED - CO2_HYSTERESIS)
+  {
+    band = Co2Low;
+  }
+  else
+  {
+    band = Co2Medium;
+  }
 
-    uint16_t savedBaseline = readEEPROM();
+  if (band == co2Band)
+  {
+    return;
+  }
 
 #ifdef MAIN_DEBUG
-    Serial.println(savedBaseline, HEX);
+  Serial.print(F("CO2 band: "));
+  Serial.println(band);
 #endif
 
-    if (baseline == savedBaseline)
-    {
-      readout = String("Saved!");
-    }
-    else
-    {
-      readout = String("Saving to EEPROM failed!");
-    }
+  Co2Band previous = co2Band;
+  co2Band = band;
+
+  if (mode == Calibrate)
+  {
+    return; // picked up by setMode() once calibration is done
   }
-  else
+
+  if (band == Co2High)
+  {
+    // jump to the CO2 readout and blink it until the air is better
+    setMode(CO2);
+    scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+  }
+  else if (previous == Co2High)
   {
-    readout = String("Failed!");
+    setMode(mode);
   }
+}
 
-  updateDisplay();
-  delay(GENERAL_DELAY);
+bool blinkHidden()
+{
+  return (millis() / BLINK_INTERVAL) & 1;
 }
 
-void onPress()
+void onGasReady()
 {
-  if (mode == Calibrate)
+  pushEvent(EventGasReady, LOW);
+}
+
+void readChannels(const BME::sSampleFixed_t &sample, int32_t *values)
+{
+  // coarse units keep history deltas small and aggregates in int16
+  values[ChannelTemperature] = (sample.temperature + (sample.temperature < 0 ? -5 : 5)) / 10;
+  values[ChannelPressure] = (sample.pressure + 5) / 10;
+  values[ChannelHumidity] = (int32_t)((sample.humidity * 10 + 512) >> 10);
+  values[ChannelCO2] = gas.eCO2;
+  values[ChannelTVOC] = gas.eTVOC;
+}
+
+void recordHistory()
+{
+  int32_t values[ChannelCount];
+
+  if (!channelsReady())
   {
-    saveBaselineToEEPROM();
-    free(onSecondTickCallbacks);
-    onSecondTickCallbacks = nullptr;
-    setMode(static_cast<ModeEnum>(0));
-    display.setTextSize(TEXT_SIZE);
-    minute = 0;
-    second = 0;
+    return;
   }
-  else
+
+  readChannels(bme.readSampleFixed(), values);
+  history.Append(values);
+}
+
+void handleSerial()
+{
+  while (Serial.available() > 0)
   {
-    incrementMode();
-    lastMeasurement = millis() - MEASUREMENT_INTERVAL;
+    switch (Serial.read())
+    {
+    case 'h':
+      dumpHistory();
+      break;
+    case 'a':
+      dumpAggregates();
+      break;
+#ifdef LOOP_PROFILE
+    case 'p':
+      printTimings();
+      break;
+    case 'r':
+      resetTimings();
+      break;
+#endif
+    }
   }
 }
 
-void onLongPress()
+void dumpHistory()
+{
+  History::Cursor cursor;
+  uint8_t age = history.Count();
+
+  Serial.print(F("# "));
+  Serial.print(age);
+  Serial.print(F(" records, "));
+  Serial.print(history.Used());
+  Serial.println(F(" bytes"));
+  Serial.println(F("min_ago,temp_c,pressure_hpa,humidity_pct,eco2_ppm,tvoc_ppb"));
+
+  history.Begin(cursor);
+
+  while (history.Next(cursor))
+  {
+    age--;
+    Serial.print(age * (HISTORY_INTERVAL / 60000UL));
+    Serial.print(',');
+    printFixed(Serial, cursor.values[0], 1, 1);
+    Serial.print(',');
+    printFixed(Serial, cursor.values[1], 1, 1);
+    Serial.print(',');
+    printFixed(Serial, cursor.values[2], 1, 1);
+    Serial.print(',');
+    Serial.print(cursor.values[3]);
+    Serial.print(',');
+    Serial.println(cursor.values[4]);
+  }
+}
+
+void onDoublePress()
 {
   if (mode == Calibrate)
   {
-    setMode(static_cast<ModeEnum>(0));
-    readout = String("Canceled!");
-    updateDisplay();
-    free(onSecondTickCallbacks);
-    onSecondTickCallbacks = nullptr;
-    display.setTextSize(TEXT_SIZE);
-    delay(GENERAL_DELAY);
     return;
   }
 
-  minute = 0;
-  second = 0;
-#ifdef MAIN_DEBUG
-  Serial.println("Calibrating baseline");
+#ifdef LOOP_PROFILE
+  // BaselineAge has no stats view, its double press opens the timings
+  if (mode == BaselineAge)
+  {
+    setMode(Diagnostics);
+    shownProbe = 0;
+    scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+    return;
+  }
+
+  if (mode == Diagnostics)
+  {
+    resetTimings();
+    return;
+  }
 #endif
 
-  onSecondTickCallbacks = (onSecondTick *)malloc(sizeof(onSecondTick) * 2);
-  onSecondTickCallbacks[0] = displayBaselineCalibrationAndTime;
-  onSecondTickCallbacks[1] = []() {
-    if (minute == MAX_TIME_FOR_CALIBRATION)
+  statsView = static_cast<StatsView>((statsView + 1) % (StatsDay + 1));
+  scheduler.Arm(sensorTask, 0, MEASUREMENT_INTERVAL);
+}
+
+// min/mean/max of the current mode's channel, false for modes without one
+bool formatStatsReading(TextBuffer &out, ModeEnum modeEnum)
+{
+  Aggregates::Stats stats;
+  uint8_t channel;
+
+  switch (modeEnum)
+  {
+  case Temperature:
+    channel = ChannelTemperature;
+    break;
+  case Pressure:
+    channel = ChannelPressure;
+    break;
+  case Humidity:
+    channel = ChannelHumidity;
+    break;
+  case CO2:
+    channel = ChannelCO2;
+    break;
+  case VOC:
+    channel = ChannelTVOC;
+    break;
+  default:
+    return false;
+  }
+
+  out.Assign(statsView == StatsHour ? F("1H ") : F("24H "));
+
+  if (!aggregates.Query(statsView == StatsHour ? AGG_HOUR : AGG_DAY, channel, millis(), stats))
+  {
+    out.print(F("no data yet"));
+    return true;
+  }
+
+  printChannel(out, channel, stats.min);
+  out.print('/');
+  printChannel(out, channel, stats.mean);
+  out.print('/');
+  printChannel(out, channel, stats.max);
+  return true;
+}
+
+// channel value in the units the readouts use
+void printChannel(Print &out, uint8_t channel, int32_t value)
+{
+  switch (channel)
+  {
+  case ChannelTemperature:
+    printFixed(out, centiCelsiusToFahrenheit(value * 10), 2, 1);
+    out.print(F("F"));
+    break;
+  case ChannelPressure:
+    printFixed(out, value, 1, 0);
+    out.print(F("MB"));
+    break;
+  case ChannelHumidity:
+    printFixed(out, value, 1, 1);
+    out.print(F("%"));
+    break;
+  case ChannelCO2:
+    out.print(value);
+    out.print(F("PPM"));
+    break;
+  case ChannelTVOC:
+    out.print(value);
+    out.print(F("PPB"));
+    break;
+  }
+}
+
+void dumpAggregates()
+{
+  Aggregates::Stats stats;
+  unsigned long now = millis();
+
+  Serial.println(F("window,channel,min,mean,max,samples"));
+
+  for (uint8_t window = AGG_HOUR; window <= AGG_DAY; window++)
+  {
+    for (uint8_t channel = 0; channel < ChannelCount; channel++)
     {
-      onPress();
+      if (!aggregates.Query(window, channel, now, stats))
+      {
+        continue;
+      }
+
+      Serial.print(window == AGG_HOUR ? F("1h,") : F("24h,"));
+      Serial.print(channel);
+      Serial.print(',');
+      printChannel(Serial, channel, stats.min);
+      Serial.print(',');
+      printChannel(Serial, channel, stats.mean);
+      Serial.print(',');
+      printChannel(Serial, channel, stats.max);
+      Serial.print(',');
+      Serial.println(stats.count);
     }
-  };
+  }
+}
 
-  setMode(Calibrate);
+#ifdef LOOP_PROFILE
+void printProbeName(Print &out, uint8_t probe)
+{
+  switch (probe)
+  {
+  case ProbeLoop:
+    out.print(F("Loop"));
+    break;
+  case ProbeButton:
+    out.print(F("Button"));
+    break;
+  case ProbeSensor:
+    out.print(F("Sensor"));
+    break;
+  case ProbeDisplay:
+    out.print(F("Display"));
+    break;
+  case ProbeTime:
+    out.print(F("Time"));
+    break;
+  }
+}
+
+// bins are relative counts, lt256 is under 256 us
+void printTimings()
+{
+  Serial.print(F("probe,samples,mean_us,max_us"));
+
+  for (uint8_t bin = 0; bin < TIMING_BINS; bin++)
+  {
+    uint16_t limit = TimingStats::BinLimit(bin);
+
+    Serial.print(limit ? F(",lt") : F(",ge"));
+    Serial.print(limit ? limit : TimingStats::BinLimit(bin - 1));
+  }
+
+  Serial.println();
+
+  for (uint8_t probe = 0; probe < ProbeCount; probe++)
+  {
+    TimingStats &stats = timings[probe];
+
+    printProbeName(Serial, probe);
+    Serial.print(',');
+    Serial.print(stats.Samples());
+    Serial.print(',');
+    Serial.print(stats.Mean());
+    Serial.print(',');
+    Serial.print(stats.Max());
+
+    for (uint8_t bin = 0; bin < TIMING_BINS; bin++)
+    {
+      Serial.print(',');
+      Serial.print(stats.Bin(bin));
+    }
+
+    Serial.println();
+  }
+}
+
+void resetTimings()
+{
+  for (uint8_t probe = 0; probe < ProbeCount; probe++)
+  {
+    timings[probe].Reset();
+  }
+}
+
+// one probe per reading, in turn
+void showTimings()
+{
+  TimingStats &stats = timings[shownProbe];
+
+  printProbeName(readout, shownProbe);
+  readout.print(F(": "));
+  readout.print(stats.Mean());
+  readout.print(F("US AVG "));
+  readout.print(stats.Max());
+  readout.print(F("US MAX"));
+
+  shownProbe = (shownProbe + 1) % ProbeCount;
+}
+#endif
+
+void showCalibrationResult(const __FlashStringHelper *message)
+{
+  readout.Assign(message);
+#ifdef MAIN_DEBUG
+  Serial.println(readout.c_str());
+#endif
+  enterCalibrationState(CalibrationShowingResult);
 }
 
 void incrementMode()
@@ -403,11 +1142,12 @@ void incrementMode()
   ModeEnum nextMode = static_cast<ModeEnum>(modeNumber);
 
 #ifdef MAIN_DEBUG
-  Serial.print("Next Mode: ");
+  Serial.print(F("Next Mode: "));
   Serial.println(modeNumber);
 #endif
 
-  if (nextMode == Calibrate)
+  // hidden modes after Calibrate lead back to the start too
+  if (nextMode >= Calibrate)
   {
     setMode(static_cast<ModeEnum>(0));
   }
@@ -417,24 +1157,49 @@ void incrementMode()
   }
 }
 
-template <typename value>
-String formatSensorReading(const char *heading, value v, String unit)
+void formatSensorReading(TextBuffer &out, const __FlashStringHelper *heading, int32_t value, uint8_t scale, uint8_t decimals, const __FlashStringHelper *unit)
 {
-  String readout;
-  readout += heading;
-  readout += ": ";
-  readout += String(v);
-  readout += unit;
-
-  return readout;
+  out.Assign(heading);
+  out.print(F(": "));
+  printFixed(out, value, scale, decimals);
+  out.print(unit);
 }
 
-void writeText(String v)
+void writeText(const TextBuffer &v)
 {
+  int16_t x1, y1;
+  uint16_t w, h;
+
+  uint32_t hash = v.Hash();
+
+  if (renderedValid && displayX == renderedX && hash == renderedHash)
+  {
+    return; // same frame as the last flush, nothing to send
+  }
+
   display.clearDisplay();
   display.setCursor(displayX, Y_CUR);
-  display.print(v);
-  display.display();
+  display.getTextBounds(v.c_str(), displayX, Y_CUR, &x1, &y1, &w, &h);
+  display.print(v.c_str());
+
+  // erase what the previous frame drew and send the new text
+  screen.MarkDirty(renderedX1, renderedY1, renderedW, renderedH);
+  screen.MarkDirty(x1, y1, w, h);
+  screen.Flush();
+
+  renderedHash = hash;
+  renderedX = displayX;
+  renderedX1 = x1;
+  renderedY1 = y1;
+  renderedW = w;
+  renderedH = h;
+  renderedValid = true;
+}
+
+void invalidateDisplay()
+{
+  renderedValid = false;
+  screen.MarkAll();
 }
 
 void printLastOperateStatus(BME::eStatus_t eStatus)
@@ -442,19 +1207,22 @@ void printLastOperateStatus(BME::eStatus_t eStatus)
   switch (eStatus)
   {
   case BME::eStatusOK:
-    Serial.println("everything ok");
+    Serial.println(F("everything ok"));
     break;
   case BME::eStatusErr:
-    Serial.println("unknow error");
+    Serial.println(F("unknow error"));
     break;
   case BME::eStatusErrDeviceNotDetected:
-    Serial.println("device not detected");
+    Serial.println(F("device not detected"));
     break;
   case BME::eStatusErrParameter:
-    Serial.println("parameter error");
+    Serial.println(F("parameter error"));
+    break;
+  case BME::eStatusBusy:
+    Serial.println(F("still starting"));
     break;
   default:
-    Serial.println("unknow status");
+    Serial.println(F("unknow status"));
     break;
   }
 }
@@ -465,13 +1233,17 @@ void setMode(ModeEnum modeEnum)
   mode = modeEnum;
   displayX = X_CUR + SCREEN_WIDTH / 2;
 
-  if (mode != Calibrate)
+  if (mode == Calibrate)
   {
-    displayMode = Scroll;
+    displayMode = Static;
+  }
+  else if (co2Band == Co2High)
+  {
+    displayMode = Blink;
   }
   else
   {
-    displayMode = Static;
+    displayMode = Scroll;
   }
 }
 
@@ -10,9 +10,25 @@
 #include "DFRobot_BME280.h"
 #include <EEPROM.h>
 #include "button.h"
+#include "dirty_display.h"
+#include "text_buffer.h"
+#include "fixed_format.h"
+#include "scheduler.h"
+#include "spsc_queue.h"
+#include "history.h"
+#include "aggregates.h"
+#include "record_store.h"
+#include "stability_detector.h"
+
+#ifndef LOOP_PROFILE
+//#define LOOP_PROFILE // micros() timing of loop() and its tasks, 'p' on Serial and a hidden page
+#endif
+
+#ifdef LOOP_PROFILE
+#include "timing_stats.h"
+#endif
 
 typedef DFRobot_BME280_IIC BME;
-typedef void (*onSecondTick)();
 
 enum ModeEnum
 {
@@ -23,9 +39,78 @@ enum ModeEnum
   CO2,
   VOC,
   BaselineAge,
-  Calibrate
+  Calibrate,
+#ifdef LOOP_PROFILE
+  Diagnostics // hidden, a double press on BaselineAge opens it
+#endif
+};
+
+enum CalibrationState
+{
+  CalibrationIdle,
+  CalibrationRunning,
+  CalibrationWaitingForData,
+  CalibrationShowingResult
+};
+
+enum Co2Band
+{
+  Co2Low,
+  Co2Medium,
+  Co2High
+};
+
+// handed from ISRs to loop() through the events queue
+enum EventType
+{
+  EventGasReady // CCS811 nINT fell
+};
+
+struct Event
+{
+  EventType type;
+  uint8_t level;
+  unsigned long time;
+};
+
+// history and aggregate channels, in 0.1 C, 0.1 hPa, 0.1 %RH, ppm and ppb
+enum Channel
+{
+  ChannelTemperature,
+  ChannelPressure,
+  ChannelHumidity,
+  ChannelCO2,
+  ChannelTVOC,
+  ChannelCount
 };
 
+enum StatsView
+{
+  StatsOff,
+  StatsHour,
+  StatsDay
+};
+
+enum DeviceState
+{
+  DeviceDown,
+  DeviceStarting,
+  DeviceUp
+};
+
+#ifdef LOOP_PROFILE
+// what loop() spends its time on, ProbeLoop is a whole pass
+enum Probe
+{
+  ProbeLoop,
+  ProbeButton,
+  ProbeSensor,
+  ProbeDisplay,
+  ProbeTime,
+  ProbeCount
+};
+#endif
+
 enum DisplayMode
 {
   Static,
@@ -37,8 +122,11 @@ enum DisplayMode
 #define SCREEN_HEIGHT 32    // OLED display height, in pixels
 #define OLED_RESET 4        // Reset pin # (or -1 if sharing Arduino reset pin)
 #define SCREEN_ADDRESS 0x3C ///< See datasheet for Address; 0x3D for 128x64, 0x3C for 128x32
-#define SEA_LEVEL_PRESSURE 1015.0f
+#define SEA_LEVEL_PRESSURE 101500UL // Pa
 #define MEASUREMENT_INTERVAL 5000
+#define BME_CONVERSION_TIME 58 // ms, first x8/x8/x8 conversion after normal mode, 57.6 ms max
+#define DISPLAY_INTERVAL 20 // ms per frame, also sets the software scroll speed
+#define SECOND_INTERVAL 1000
 #define GENERAL_DELAY 5000
 #define BASELINE_AGE_MAX 24 // 24 hrs
 #define TEXT_SIZE 2
@@ -46,51 +134,185 @@ enum DisplayMode
 #define X_CUR 0
 #define PX_PER_CHAR 6
 #define BTN_PIN 3
+#define CCS811_INT_PIN 2 // CCS811 nINT, comment out to poll the sensor instead
+//#define CO2_THRESHOLD_ALERT // nINT on eCO2 band changes instead of every frame, readings are polled
+#define CO2_LOW_TO_MED 1000  // ppm, from the CO2 table at the bottom of main.cpp
+#define CO2_MED_TO_HIGH 2500 // ppm
+#define CO2_HYSTERESIS 50    // ppm
+#define BLINK_INTERVAL 500
+#define EVENT_QUEUE_SIZE 2 // power of two, nINT falls at most once a frame
+#define HISTORY_INTERVAL 300000UL // 5 min, HISTORY_BYTES keep about 2 hrs of quiet air
+#define SERIAL_INTERVAL 50
+
+#if defined(CO2_THRESHOLD_ALERT) && !defined(CCS811_INT_PIN)
+#error "CO2_THRESHOLD_ALERT reports band changes on nINT, it needs CCS811_INT_PIN"
+#endif
+
+#if !defined(CCS811_INT_PIN) || defined(CO2_THRESHOLD_ALERT)
+#define GAS_POLLING // gas results are fetched by the tasks that need them
+#define GAS_FRAME_INTERVAL MEASUREMENT_INTERVAL
+#else
+#define GAS_FRAME_INTERVAL 1000
+#endif
+
+// warm-up ends early once RAW_DATA voltage and eCO2 settled, within
+// 2 LSB and 10 ppm or 3 % respectively, MIN_TIME_FOR_CALIBRATION caps it
+#define STABILITY_SHIFT 5 // 32 frame window
+#define STABILITY_MIN_SAMPLES (120000UL / GAS_FRAME_INTERVAL)
+#define STABILITY_HOLD_SAMPLES (30000UL / GAS_FRAME_INTERVAL)
 #define EEPROM_ADDR 0
+#define EEPROM_BYTES 1024
+#define RECORD_TAG_BASELINE 1
+#define RECORD_TAG_HOURS 2         // powered hours, the clock baseline ages are kept in
+#define RECORD_TAG_BASELINE_HOUR 3 // powered hour the baseline was saved at
+#define HOUR_INTERVAL 3600000UL
+#define BOOT_POLL_INTERVAL 2   // ms between readiness polls of a starting sensor
+#define BOOT_START_TIMEOUT 100 // ms a starting sensor may stay busy or silent
+#define BOOT_RETRY_MIN 250     // backoff between attempts, doubling up to BOOT_RETRY_MAX
+#define BOOT_RETRY_MAX 30000
 #define MAX_TIME_FOR_CALIBRATION 20
 #define MIN_TIME_FOR_CALIBRATION 20
+#define DATA_POLL_INTERVAL 250
+#define DATA_WAIT_TIMEOUT 30000UL
+#define READOUT_CAPACITY 64 // longest message plus the terminator
+#define READOUT_DECIMALS 2
 
-unsigned long lastMeasurement = millis();
-unsigned long baselineAge = millis() / 1000 / 60 / 60;
 int displayX;
 int displayMinX;
-String readout;
+StaticText<READOUT_CAPACITY> readout;
 uint16_t baseline;
 ModeEnum mode;
 ModeEnum lastMode;
 DisplayMode displayMode;
+CalibrationState calibrationState = CalibrationIdle;
 int minute = 0;
 int second = 0;
-int lastSecond = millis();
-char *waiting = "...";
+const char *waiting = "...";
 int textSize = TEXT_SIZE;
 bool baselineUpdated = false;
+bool baselineSaved = false;
+uint16_t poweredHours = 0;
+uint16_t baselineHour = 0;
+DFRobot_CCS811::sResult_t gas;
+uint8_t gasFrames = 0;
+uint8_t calibrationGasFrames;
+SpscQueue<Event, EVENT_QUEUE_SIZE> events;
+Co2Band co2Band = Co2Low;
+bool co2BandValid = false; // set by the first band check after warm-up
+StaticText<1> blankText;
 
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+DirtyDisplay screen(&display, &Wire, SCREEN_ADDRESS);
 DFRobot_CCS811 CCS811(&Wire, /*IIC_ADDRESS=*/0x5A);
 BME bme(&Wire, 0x76);
 Button modeBtn = Button(BTN_PIN);
-onSecondTick *onSecondTickCallbacks = nullptr;
+Scheduler scheduler;
+TaskId sensorTask;
+TaskId displayTask;
+TaskId timeTask;
+TaskId calibrationTask;
+TaskId calibrationTimeoutTask;
+TaskId historyTask;
+TaskId serialTask;
+TaskId hourTask;
+TaskId bmeBootTask;
+TaskId ccsBootTask;
+DeviceState bmeState = DeviceDown;
+DeviceState ccsState = DeviceDown;
+unsigned long bmeStarted;
+unsigned long ccsStarted;
+uint16_t bmeRetry = BOOT_RETRY_MIN;
+uint16_t ccsRetry = BOOT_RETRY_MIN;
+History history;
+Aggregates aggregates;
+RecordStore records(EEPROM_ADDR, EEPROM_BYTES);
+StabilityDetector voltageStability(STABILITY_SHIFT, 2, 0, STABILITY_MIN_SAMPLES, STABILITY_HOLD_SAMPLES);
+StabilityDetector co2Stability(STABILITY_SHIFT, 10, 3, STABILITY_MIN_SAMPLES, STABILITY_HOLD_SAMPLES);
+StatsView statsView = StatsOff;
+uint32_t renderedHash;
+int renderedX;
+int16_t renderedX1;
+int16_t renderedY1;
+uint16_t renderedW;
+uint16_t renderedH;
+bool renderedValid = false;
+bool hardwareScrolling = false;
+#ifdef LOOP_PROFILE
+TimingStats timings[ProbeCount];
+uint8_t shownProbe = 0;
+#endif
 
-void writeText(String v);
+void writeText(const TextBuffer &v);
+void invalidateDisplay();
 void testscrolltext(void);
 void printLastOperateStatus(BME::eStatus_t eStatus);
 void onPress();
 void onLongPress();
-template <typename value>
-String formatSensorReading(const char *heading, value v, String unit);
+void formatSensorReading(TextBuffer &out, const __FlashStringHelper *heading, int32_t value, uint8_t scale, uint8_t decimals, const __FlashStringHelper *unit);
 void updateTime();
 void displayBaselineCalibrationAndTime();
 void updateDisplay();
 void saveBaselineToEEPROM();
-uint16_t readEEPROM();
 void updateSensorReading();
 void incrementMode();
 void setMode(ModeEnum modeEnum);
 void updateWaiting();
 void updateStaticDisplay();
 void updateScrollDisplay();
+bool fitsHardwareScroll(const TextBuffer &v);
+void updateHardwareScroll();
+void stopHardwareScroll();
 void updateBlinkDisplay();
-void restoreBaseline();
+bool restoreBaseline();
+bool persistBaseline();
+bool warmedUp();
+void bootBme();
+void bootCcs();
+void advanceBoot(DeviceState &state, unsigned long &started, uint16_t &retry, TaskId task, bool ready, bool busy);
+void startGasSensor();
+bool usesGas(ModeEnum modeEnum);
+bool sensorsUp(ModeEnum modeEnum);
+bool channelsReady();
+void countHour();
+void calibrationTimeout();
+void handleEvents();
+void pushEvent(EventType type, uint8_t level);
+void recordHistory();
+void handleSerial();
+void dumpHistory();
+void readChannels(const BME::sSampleFixed_t &sample, int32_t *values);
+void onDoublePress();
+bool formatStatsReading(TextBuffer &out, ModeEnum modeEnum);
+void printChannel(Print &out, uint8_t channel, int32_t value);
+void dumpAggregates();
+void readGas();
+void updateCo2Band(uint16_t eCO2);
+bool blinkHidden();
+void onGasReady();
+void stepCalibration();
+void enterCalibrationState(CalibrationState state);
+void showCalibrationResult(const __FlashStringHelper *message);
+#ifdef __AVR__
+int freeRam();
+#endif
+
+#ifdef LOOP_PROFILE
+void printProbeName(Print &out, uint8_t probe);
+void printTimings();
+void resetTimings();
+void showTimings();
+
+// runs a scheduler task and adds its duration to the probe
+template <void (*task)(), Probe probe> void profiled()
+{
+  unsigned long start = micros();
+  task();
+  timings[probe].Add(micros() - start);
+}
+
+#define PROFILED(probe, task) profiled<task, probe>
+#else
+#define PROFILED(probe, task) task
+#endif
 
 #endif
\ No newline at end of file
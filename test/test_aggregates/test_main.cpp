@@ -0,0 +1,233 @@
+// Aggregates windows and millis() rollover, pio test -e native
+#include <unity.h>
+#include "aggregates.h"
+
+#define WRAP 0x100000000ULL // millis() on the AVR wraps at 2^32
+
+static Aggregates aggregates;
+
+// millis() as the AVR returns it, whatever the host's unsigned long
+static unsigned long clock32(unsigned long long ms)
+{
+    return (unsigned long)(ms % WRAP);
+}
+
+// the same value on every channel
+static void add(int32_t value, unsigned long now)
+{
+    int32_t values[AGG_CHANNELS];
+
+    for (uint8_t i = 0; i < AGG_CHANNELS; i++)
+    {
+        values[i] = value;
+    }
+
+    aggregates.Add(values, now);
+}
+
+// mean of first..last, rounded half up like the buckets do
+static int16_t roundedMean(int16_t first, int16_t last)
+{
+    return (first + last + 1) / 2;
+}
+
+static Aggregates::Stats query(uint8_t window, unsigned long now)
+{
+    Aggregates::Stats stats = {0, 0, 0, 0};
+
+    aggregates.Query(window, AGG_CHANNELS - 1, now, stats);
+    return stats;
+}
+
+void setUp()
+{
+    aggregates.Clear(0);
+}
+
+void tearDown()
+{
+}
+
+void test_empty()
+{
+    Aggregates::Stats stats;
+
+    TEST_ASSERT_FALSE(aggregates.Query(AGG_HOUR, 0, 0, stats));
+    TEST_ASSERT_FALSE(aggregates.Query(AGG_DAY, 0, AGG_FAST_MS * 5, stats));
+}
+
+void test_mean_rounds_half_away_from_zero()
+{
+    add(1, 0);
+    add(2, 1000);
+    TEST_ASSERT_EQUAL_INT16(2, query(AGG_HOUR, 2000).mean);
+
+    aggregates.Clear(0);
+    add(-1, 0);
+    add(-2, 1000);
+    TEST_ASSERT_EQUAL_INT16(-2, query(AGG_HOUR, 2000).mean);
+}
+
+void test_values_clamp_to_int16()
+{
+    add(100000, 0);
+    add(-100000, 1000);
+
+    Aggregates::Stats stats = query(AGG_HOUR, 2000);
+
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, stats.min);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, stats.max);
+}
+
+// the hour window is the open 30 min bucket and the two closed before it,
+// a sample stays in it for at least an hour
+void test_hour_window_boundaries()
+{
+    add(10, 0);
+    add(20, AGG_FAST_MS - 1);
+
+    Aggregates::Stats stats = query(AGG_HOUR, AGG_FAST_MS - 1);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+
+    add(30, AGG_FAST_MS);
+    add(40, 2 * AGG_FAST_MS);
+    stats = query(AGG_HOUR, 3 * AGG_FAST_MS - 1);
+    TEST_ASSERT_EQUAL_UINT16(4, stats.count);
+    TEST_ASSERT_EQUAL_INT16(10, stats.min);
+    TEST_ASSERT_EQUAL_INT16(40, stats.max);
+    TEST_ASSERT_EQUAL_INT16(25, stats.mean);
+
+    // first bucket drops out of the hour, stays in the day
+    stats = query(AGG_HOUR, 3 * AGG_FAST_MS);
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+    TEST_ASSERT_EQUAL_INT16(30, stats.min);
+    TEST_ASSERT_EQUAL_INT16(40, stats.max);
+
+    stats = query(AGG_DAY, 3 * AGG_FAST_MS);
+    TEST_ASSERT_EQUAL_UINT16(4, stats.count);
+    TEST_ASSERT_EQUAL_INT16(10, stats.min);
+
+    // all closed buckets gone
+    TEST_ASSERT_EQUAL_UINT16(0, query(AGG_HOUR, 5 * AGG_FAST_MS).count);
+}
+
+// the day window is the open 12 hr bucket and the two closed before it,
+// a sample stays in it for at least 24 hrs
+void test_day_window_boundaries()
+{
+    const uint8_t span = AGG_SLOW_SPAN;
+    const uint8_t buckets = AGG_SLOW_SPAN * AGG_SLOW_BUCKETS;
+
+    // one sample per 30 min bucket, its index as the value
+    for (uint8_t k = 0; k < buckets; k++)
+    {
+        add(k, k * AGG_FAST_MS);
+    }
+
+    Aggregates::Stats stats = query(AGG_DAY, buckets * AGG_FAST_MS - 1);
+    TEST_ASSERT_EQUAL_UINT16(buckets, stats.count);
+    TEST_ASSERT_EQUAL_INT16(0, stats.min);
+    TEST_ASSERT_EQUAL_INT16(buckets - 1, stats.max);
+
+    // the oldest 12 hrs drop out as the last one closes
+    stats = query(AGG_DAY, buckets * AGG_FAST_MS);
+    TEST_ASSERT_EQUAL_UINT16(buckets - span, stats.count);
+    TEST_ASSERT_EQUAL_INT16(span, stats.min);
+    TEST_ASSERT_EQUAL_INT16(buckets - 1, stats.max);
+
+    // the 12 hr means rounded, then averaged
+    TEST_ASSERT_EQUAL_INT16(roundedMean(roundedMean(span, 2 * span - 1), roundedMean(2 * span, 3 * span - 1)), stats.mean);
+
+    stats = query(AGG_DAY, (buckets + span) * AGG_FAST_MS);
+    TEST_ASSERT_EQUAL_UINT16(span, stats.count);
+    TEST_ASSERT_EQUAL_INT16(2 * span, stats.min);
+}
+
+// closed buckets keep min and max as byte offsets from the mean, wider
+// spans are stored in coarser steps and may only widen
+void test_closed_range_rounds_outwards()
+{
+    add(-100, 0);
+    add(150, 1000);
+
+    // span under AGG_RANGE_MAX, exact
+    Aggregates::Stats stats = query(AGG_HOUR, AGG_FAST_MS);
+    TEST_ASSERT_EQUAL_INT16(-100, stats.min);
+    TEST_ASSERT_EQUAL_INT16(150, stats.max);
+
+    // mean 501, offsets 501 and 500 go in steps of 2
+    aggregates.Clear(0);
+    add(0, 0);
+    add(1001, 1000);
+    stats = query(AGG_HOUR, AGG_FAST_MS);
+    TEST_ASSERT_EQUAL_INT16(501, stats.mean);
+    TEST_ASSERT_EQUAL_INT16(-1, stats.min);
+    TEST_ASSERT_EQUAL_INT16(1001, stats.max);
+
+    // the extremes of the channel range clamp instead of wrapping
+    aggregates.Clear(0);
+    add(INT16_MIN, 0);
+    add(INT16_MAX, 1000);
+    stats = query(AGG_DAY, AGG_FAST_MS * AGG_SLOW_SPAN);
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, stats.min);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, stats.max);
+}
+
+// a day of silence starts over rather than closing empty buckets
+void test_gap_clears()
+{
+    add(10, 0);
+    TEST_ASSERT_EQUAL_UINT16(1, query(AGG_DAY, AGG_FAST_MS * AGG_SLOW_SPAN * AGG_SLOW_BUCKETS - 1).count);
+    TEST_ASSERT_EQUAL_UINT16(0, query(AGG_DAY, AGG_FAST_MS * AGG_SLOW_SPAN * AGG_SLOW_BUCKETS).count);
+}
+
+// samples either side of the wrap share the open bucket
+void test_rollover_same_bucket()
+{
+    unsigned long long start = WRAP - 1000;
+
+    aggregates.Clear(clock32(start));
+    add(10, clock32(start));
+    add(20, clock32(start + 1500));
+
+    Aggregates::Stats stats = query(AGG_HOUR, clock32(start + 2000));
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+    TEST_ASSERT_EQUAL_INT16(10, stats.min);
+    TEST_ASSERT_EQUAL_INT16(20, stats.max);
+}
+
+// buckets keep closing on time across the wrap, nothing is cleared
+void test_rollover_boundaries()
+{
+    unsigned long long start = WRAP - AGG_FAST_MS / 2;
+
+    aggregates.Clear(clock32(start));
+    add(10, clock32(start));
+    add(20, clock32(start + AGG_FAST_MS));
+
+    Aggregates::Stats stats = query(AGG_HOUR, clock32(start + AGG_FAST_BUCKETS * AGG_FAST_MS - 1));
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+    TEST_ASSERT_EQUAL_INT16(10, stats.min);
+
+    stats = query(AGG_HOUR, clock32(start + AGG_FAST_BUCKETS * AGG_FAST_MS));
+    TEST_ASSERT_EQUAL_UINT16(1, stats.count);
+    TEST_ASSERT_EQUAL_INT16(20, stats.min);
+
+    stats = query(AGG_DAY, clock32(start + AGG_FAST_BUCKETS * AGG_FAST_MS));
+    TEST_ASSERT_EQUAL_UINT16(2, stats.count);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty);
+    RUN_TEST(test_mean_rounds_half_away_from_zero);
+    RUN_TEST(test_values_clamp_to_int16);
+    RUN_TEST(test_hour_window_boundaries);
+    RUN_TEST(test_day_window_boundaries);
+    RUN_TEST(test_closed_range_rounds_outwards);
+    RUN_TEST(test_gap_clears);
+    RUN_TEST(test_rollover_same_bucket);
+    RUN_TEST(test_rollover_boundaries);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// calAltitudeFixed accuracy against pow() in double, pio test -e native
+#include <unity.h>
+#include <math.h>
+#include "DFRobot_BME280.h"
+
+#define SWEEP_MAX_ERROR 0.25    // m, 300 ~ 1100 hpa against 950 ~ 1050 hpa sea level
+#define RATIO_MAX_ERROR 0.5     // m, documented for ratios 0.25 ~ 1.25
+
+// calAltitudeFixed needs no bus
+class TestBme280 : public DFRobot_BME280
+{
+protected:
+    void writeReg(uint8_t reg, uint8_t *pBuf, uint16_t len)
+    {
+    }
+
+    void readReg(uint8_t reg, uint8_t *pBuf, uint16_t len)
+    {
+    }
+};
+
+static TestBme280 bme;
+
+static double exactAltitude(uint32_t seaLevel, uint32_t pressure)
+{
+    return 44330.0 * (1 - pow((double) pressure / seaLevel, 0.1903));
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// the range the sensor is specified for, and the one altitude mode sees
+void test_sweep_pressure_range()
+{
+    double worst = 0;
+
+    for (uint32_t seaLevel = 95000; seaLevel <= 105000; seaLevel += 250)
+    {
+        int32_t previous = INT32_MAX;
+
+        for (uint32_t pressure = 30000; pressure <= 110000; pressure += 7)
+        {
+            int32_t altitude = bme.calAltitudeFixed(seaLevel, pressure);
+            double error = fabs(altitude / 100.0 - exactAltitude(seaLevel, pressure));
+
+            if (error > worst)
+            {
+                worst = error;
+            }
+
+            // interpolation must not step back up between table entries
+            TEST_ASSERT_LESS_OR_EQUAL_INT32(previous, altitude);
+            previous = altitude;
+        }
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(worst <= SWEEP_MAX_ERROR, "altitude off by more than 0.25 m");
+}
+
+// every ratio the table covers, at a sea level far from standard
+void test_sweep_table_range()
+{
+    const uint32_t seaLevel = 80000;
+    double worst = 0;
+
+    for (uint32_t pressure = seaLevel / 4; pressure < seaLevel + seaLevel / 4; pressure += 3)
+    {
+        double error = fabs(bme.calAltitudeFixed(seaLevel, pressure) / 100.0 - exactAltitude(seaLevel, pressure));
+
+        if (error > worst)
+        {
+            worst = error;
+        }
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(worst <= RATIO_MAX_ERROR, "altitude off by more than 0.5 m");
+}
+
+void test_edges()
+{
+    TEST_ASSERT_EQUAL_INT32(0, bme.calAltitudeFixed(101325, 101325));
+    TEST_ASSERT_EQUAL_INT32(0, bme.calAltitudeFixed(0, 101325));
+
+    // ratios outside 0.25 ~ 1.25 clamp to the table ends
+    TEST_ASSERT_EQUAL_INT32(bme.calAltitudeFixed(100000, 25000), bme.calAltitudeFixed(100000, 10));
+    TEST_ASSERT_EQUAL_INT32(bme.calAltitudeFixed(100000, 125000), bme.calAltitudeFixed(100000, 200000));
+
+    // the float wrapper takes hpa
+    TEST_ASSERT_EQUAL_FLOAT(bme.calAltitudeFixed(101325, 89874) / 100.0f, bme.calAltitude(1013.25f, 89874));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sweep_pressure_range);
+    RUN_TEST(test_sweep_table_range);
+    RUN_TEST(test_edges);
+    return UNITY_END();
+}
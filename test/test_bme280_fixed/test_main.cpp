@@ -0,0 +1,266 @@
+// Fixed point BME280 compensation against the float code it replaced, pio test -e native
+#include <unity.h>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include "DFRobot_BME280.h"
+
+#define CALIBRATION_SETS 200
+#define SAMPLES_PER_SET 5000
+#define PRESSURE32_MAX_ERROR 7    // pa, datasheet calibration
+
+// typical calibration from the datasheet, t1 ~ p9 and h1 at 0xa1
+static const uint16_t DATASHEET_CALIB[12] = {
+    27504, 26435, (uint16_t)-1000, 36477, (uint16_t)-10685, 3024,
+    2855, 140, (uint16_t)-7, 15500, (uint16_t)-14600, 6000};
+
+// register file fake, the burst and calibration reads come from regs
+class TestBme280 : public DFRobot_BME280
+{
+public:
+    uint8_t regs[256];
+
+    using DFRobot_BME280::getCalibrate;
+    using DFRobot_BME280::compensatePressure;
+    using DFRobot_BME280::compensatePressure32;
+
+    void SetCalibration(const uint16_t *calib, uint8_t e5)
+    {
+        memset(regs, 0, sizeof(regs));
+        memcpy(regs + 0x88, calib, 24);
+        regs[0xa1] = 75;
+        regs[0xe1] = 0x6d;
+        regs[0xe2] = 0x01;
+        regs[0xe4] = 0x13;
+        regs[0xe5] = e5;
+        regs[0xe6] = 0x03;
+        regs[0xe7] = 0x1e;
+        getCalibrate();
+    }
+
+    void SetRaw(int32_t temp, int32_t press, int32_t humi)
+    {
+        uint8_t *r = regs + 0xf7;
+
+        r[0] = press >> 12;
+        r[1] = press >> 4;
+        r[2] = (press & 15) << 4;
+        r[3] = temp >> 12;
+        r[4] = temp >> 4;
+        r[5] = (temp & 15) << 4;
+        r[6] = humi >> 8;
+        r[7] = humi;
+    }
+
+    // previous float implementation, kept verbatim apart from the raw argument
+    float OldTemperature(int32_t raw)
+    {
+        int32_t v1, v2;
+        float rslt;
+
+        v1 = ((((raw >> 3) - ((int32_t) _sCalib.t1 << 1))) * ((int32_t) _sCalib.t2)) >> 11;
+        v2 = (((((raw >> 4) - ((int32_t) _sCalib.t1)) * ((raw >> 4) - ((int32_t) _sCalib.t1))) >> 12) * ((int32_t) _sCalib.t3)) >> 14;
+        _oldFine = v1 + v2;
+        rslt = (_oldFine * 5 + 128) >> 8;
+        return (rslt / 100);
+    }
+
+    uint32_t OldPressure(int32_t raw)
+    {
+        int64_t rslt, v1, v2;
+
+        v1 = ((int64_t) _oldFine) - 128000;
+        v2 = v1 * v1 * (int64_t) _sCalib.p6;
+        v2 = v2 + ((v1 * (int64_t) _sCalib.p5) << 17);
+        v2 = v2 + (((int64_t) _sCalib.p4) << 35);
+        v1 = ((v1 * v1 * (int64_t) _sCalib.p3) >> 8) + ((v1 * (int64_t) _sCalib.p2) << 12);
+        v1 = (((((int64_t) 1) << 47) + v1)) * ((int64_t) _sCalib.p1) >> 33;
+        if (v1 == 0)
+            return 0;
+        rslt = 1048576 - raw;
+        rslt = (((rslt << 31) - v2) * 3125) / v1;
+        v1 = (((int64_t) _sCalib.p9) * (rslt >> 13) * (rslt >> 13)) >> 25;
+        v2 = (((int64_t) _sCalib.p8) * rslt) >> 19;
+        rslt = ((rslt + v1 + v2) >> 8) + (((int64_t) _sCalib.p7) << 4);
+        return (uint32_t) (rslt / 256);
+    }
+
+    float OldHumidity(int32_t raw)
+    {
+        int32_t v1;
+
+        v1 = (_oldFine - ((int32_t) 76800));
+        v1 = (((((raw << 14) - (((int32_t) _sCalibHumi.h4) << 20) - (((int32_t) _sCalibHumi.h5) * v1)) +
+             ((int32_t) 16384)) >> 15) * (((((((v1 * ((int32_t) _sCalibHumi.h6)) >> 10) * (((v1 *
+             ((int32_t) _sCalibHumi.h3)) >> 11) + ((int32_t) 32768))) >> 10) + ((int32_t) 2097152)) *
+             ((int32_t) _sCalibHumi.h2) + 8192) >> 14));
+        v1 = (v1 - (((((v1 >> 15) * (v1 >> 15)) >> 7) * ((int32_t) _sCalibHumi.h1)) >> 4));
+        v1 = (v1 < 0 ? 0 : v1);
+        v1 = (v1 > 419430400 ? 419430400 : v1);
+        return ((float) (v1 >> 12)) / 1024.0f;
+    }
+
+protected:
+    void writeReg(uint8_t reg, uint8_t *pBuf, uint16_t len)
+    {
+        memcpy(regs + reg, pBuf, len);
+        lastOperateStatus = eStatusOK;
+    }
+
+    void readReg(uint8_t reg, uint8_t *pBuf, uint16_t len)
+    {
+        memcpy(pBuf, regs + reg, len);
+        lastOperateStatus = eStatusOK;
+    }
+
+private:
+    int32_t _oldFine;
+};
+
+static TestBme280 bme;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// raw temperature 0x80000 is the skipped-measurement marker, not a reading
+static int32_t rawTemperature(std::mt19937 &rng)
+{
+    std::uniform_int_distribution<int32_t> dist(350000, 650000);
+    int32_t raw;
+
+    do
+    {
+        raw = dist(rng);
+    } while (raw == 0x80000);
+
+    return raw;
+}
+
+// random calibration sets spread around the datasheet values
+void test_matches_float_implementation()
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> jitter(-2000, 2000);
+    std::uniform_int_distribution<int32_t> rawPress(200000, 500000);
+    std::uniform_int_distribution<int32_t> rawHumi(10000, 60000);
+    uint32_t mismatches = 0;
+
+    for (int set = 0; set < CALIBRATION_SETS; set++)
+    {
+        uint16_t calib[12];
+
+        for (int i = 0; i < 12; i++)
+        {
+            int spread = (i == 0 || i == 3) ? jitter(rng) * 4 : jitter(rng) / (i > 6 ? 8 : 1);
+            calib[i] = DATASHEET_CALIB[i] + spread;
+        }
+
+        bme.SetCalibration(calib, 0x25 ^ (set & 7));
+
+        for (int k = 0; k < SAMPLES_PER_SET; k++)
+        {
+            int32_t temp = rawTemperature(rng);
+            int32_t press = rawPress(rng);
+            int32_t humi = rawHumi(rng);
+
+            bme.SetRaw(temp, press, humi);
+
+            float oldTemp = bme.OldTemperature(temp);
+            uint32_t oldPress = bme.OldPressure(press);
+            float oldHumi = bme.OldHumidity(humi);
+            DFRobot_BME280::sSample_t sample = bme.readSample();
+
+            // bit compare, == would let -0.0f and 0.0f through
+            if (memcmp(&oldTemp, &sample.temperature, sizeof(float)) != 0 ||
+                oldPress != sample.pressure ||
+                memcmp(&oldHumi, &sample.humidity, sizeof(float)) != 0)
+            {
+                mismatches++;
+            }
+
+            if (bme.getTemperature() != oldTemp || bme.getPressure() != oldPress || bme.getHumidity() != oldHumi)
+            {
+                mismatches++;
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+// the fixed sample is the exact integer the float was divided from
+void test_fixed_sample_units()
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int32_t> rawPress(200000, 500000);
+    std::uniform_int_distribution<int32_t> rawHumi(10000, 60000);
+
+    bme.SetCalibration(DATASHEET_CALIB, 0x25);
+
+    for (int k = 0; k < SAMPLES_PER_SET; k++)
+    {
+        int32_t temp = rawTemperature(rng);
+        int32_t press = rawPress(rng);
+        int32_t humi = rawHumi(rng);
+
+        bme.SetRaw(temp, press, humi);
+
+        float oldTemp = bme.OldTemperature(temp);
+        uint32_t oldPress = bme.OldPressure(press);
+        float oldHumi = bme.OldHumidity(humi);
+        const DFRobot_BME280::sSampleFixed_t &fixed = bme.readSampleFixed();
+
+        TEST_ASSERT_EQUAL(DFRobot_BME280::eStatusOK, bme.lastOperateStatus);
+        TEST_ASSERT_EQUAL_FLOAT(oldTemp, (float) fixed.temperature / 100);
+        TEST_ASSERT_EQUAL_UINT32(oldPress, fixed.pressure);
+        TEST_ASSERT_EQUAL_FLOAT(oldHumi, (float) fixed.humidity / 1024.0f);
+    }
+}
+
+// the 32 bit variant BME280_PRESSURE_INT32 selects, over the whole raw range
+void test_pressure32_close_to_64()
+{
+    int32_t worst = 0;
+
+    bme.SetCalibration(DATASHEET_CALIB, 0x25);
+
+    for (int32_t temp = 400000; temp <= 600000; temp += 25000)
+    {
+        bme.SetRaw(temp, 0, 0);
+        bme.readSampleFixed();
+
+        for (int32_t press = 0; press < 0x100000; press += 13)
+        {
+            uint32_t pa = bme.compensatePressure(press);
+
+            // outside the 300 ~ 1100 hpa the sensor is specified for
+            if (pa < 30000 || pa > 110000)
+            {
+                continue;
+            }
+
+            int32_t error = labs((long) bme.compensatePressure32(press) - (long) pa);
+
+            if (error > worst)
+            {
+                worst = error;
+            }
+        }
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(PRESSURE32_MAX_ERROR, worst);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_float_implementation);
+    RUN_TEST(test_fixed_sample_units);
+    RUN_TEST(test_pressure32_close_to_64);
+    return UNITY_END();
+}
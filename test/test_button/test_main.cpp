@@ -0,0 +1,120 @@
+// Button classification against loop speed, pio test -e native
+#include <unity.h>
+#include "native_hal.h"
+#include "button.h"
+
+#define BUTTON_PIN 2
+#define PRESS_AT 1000UL
+#define BOUNCE_MS 3
+
+static uint16_t presses;
+static uint16_t longPresses;
+
+static void onPress()
+{
+    presses++;
+}
+
+static void onLongPress()
+{
+    longPresses++;
+}
+
+// edges of one press held for hold ms, with contact bounce on both ends
+static uint8_t makeEdges(unsigned long hold, unsigned long *times, uint8_t *levels)
+{
+    const unsigned long release = PRESS_AT + hold;
+    const unsigned long at[] = {PRESS_AT, PRESS_AT + BOUNCE_MS, PRESS_AT + 2 * BOUNCE_MS,
+                                release, release + BOUNCE_MS, release + 2 * BOUNCE_MS};
+    const uint8_t level[] = {BTN_PRESSED, BTN_NOT_PRESSED, BTN_PRESSED,
+                             BTN_NOT_PRESSED, BTN_PRESSED, BTN_NOT_PRESSED};
+
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        times[i] = at[i];
+        levels[i] = level[i];
+    }
+
+    return 6;
+}
+
+// the edges are stamped when they happen, like the ISR does, and handed
+// over whenever the loop gets to run
+static void run(unsigned long hold, unsigned long loopPeriod)
+{
+    Button button(BUTTON_PIN);
+    unsigned long times[6];
+    uint8_t levels[6];
+    uint8_t count = makeEdges(hold, times, levels);
+    uint8_t next = 0;
+
+    presses = 0;
+    longPresses = 0;
+    button.DisablePolling();
+    button.OnPress(onPress);
+    button.OnLongPress(onLongPress);
+
+    for (unsigned long now = 0; now < PRESS_AT + hold + 4 * LONG_PRESS; now += loopPeriod)
+    {
+        Native.SetTime((uint64_t)now * 1000);
+
+        while (next < count && times[next] <= now)
+        {
+            button.PushEdge(levels[next], times[next]);
+            next++;
+        }
+
+        button.Update();
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// holds around LONG_PRESS at a 1 ms loop and at loops slower than DEBOUNCE
+void test_same_callback_at_any_loop_period()
+{
+    const unsigned long periods[] = {1, 7, 50, 250, 1000};
+
+    for (unsigned long hold = LONG_PRESS - 100; hold <= LONG_PRESS + 100; hold++)
+    {
+        bool isLong = hold >= LONG_PRESS;
+
+        for (uint8_t p = 0; p < sizeof(periods) / sizeof(periods[0]); p++)
+        {
+            char message[48];
+
+            run(hold, periods[p]);
+            snprintf(message, sizeof(message), "hold %lu ms, loop %lu ms", hold, periods[p]);
+            TEST_ASSERT_EQUAL_UINT16_MESSAGE(isLong ? 0 : 1, presses, message);
+            TEST_ASSERT_EQUAL_UINT16_MESSAGE(isLong ? 1 : 0, longPresses, message);
+        }
+    }
+}
+
+// the case that used to depend on the loop, release bouncing past LONG_PRESS
+void test_release_settling_across_long_press()
+{
+    unsigned long hold = LONG_PRESS - 30;
+
+    run(hold, 1);
+    TEST_ASSERT_EQUAL_UINT16(1, presses);
+    TEST_ASSERT_EQUAL_UINT16(0, longPresses);
+
+    run(hold, 250);
+    TEST_ASSERT_EQUAL_UINT16(1, presses);
+    TEST_ASSERT_EQUAL_UINT16(0, longPresses);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_same_callback_at_any_loop_period);
+    RUN_TEST(test_release_settling_across_long_press);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+// SpscQueue on the host, pio test -e native
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "spsc_queue.h"
+
+#define STRESS_ITEMS 2000000UL
+
+// the check word catches a slot read while the producer was still writing it
+struct Item
+{
+    uint32_t sequence;
+    uint32_t check;
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_fills_to_capacity()
+{
+    SpscQueue<uint8_t, 4> queue;
+    uint8_t value;
+
+    TEST_ASSERT_TRUE(queue.IsEmpty());
+    TEST_ASSERT_FALSE(queue.Pop(value));
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_TRUE(queue.Push(i));
+    }
+
+    TEST_ASSERT_FALSE(queue.Push(4));
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_TRUE(queue.Pop(value));
+        TEST_ASSERT_EQUAL_UINT8(i, value);
+    }
+
+    TEST_ASSERT_TRUE(queue.IsEmpty());
+}
+
+// the byte indices wrap every 256 items, the full check must hold across it
+void test_index_wrap()
+{
+    SpscQueue<uint16_t, 128> queue;
+    uint16_t value;
+    uint16_t pushed = 0;
+    uint16_t popped = 0;
+
+    for (uint16_t round = 0; round < 10; round++)
+    {
+        while (queue.Push(pushed))
+        {
+            pushed++;
+        }
+
+        TEST_ASSERT_EQUAL_UINT16(128, pushed - popped);
+
+        for (uint8_t i = 0; i < 100; i++)
+        {
+            TEST_ASSERT_TRUE(queue.Pop(value));
+            TEST_ASSERT_EQUAL_UINT16(popped, value);
+            popped++;
+        }
+    }
+}
+
+template <uint8_t N>
+void stress()
+{
+    static SpscQueue<Item, N> queue;
+    std::atomic<bool> torn(false);
+    std::atomic<bool> reordered(false);
+    uint32_t received = 0;
+
+    std::thread consumer([&]() {
+        Item item;
+
+        while (received < STRESS_ITEMS)
+        {
+            if (!queue.Pop(item))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (item.check != ~item.sequence)
+            {
+                torn = true;
+            }
+
+            if (item.sequence != received)
+            {
+                reordered = true;
+            }
+
+            received++;
+        }
+    });
+
+    for (uint32_t sequence = 0; sequence < STRESS_ITEMS; sequence++)
+    {
+        Item item = {sequence, ~sequence};
+
+        while (!queue.Push(item))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    consumer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(STRESS_ITEMS, received);
+    TEST_ASSERT_FALSE_MESSAGE(torn.load(), "item read while it was written");
+    TEST_ASSERT_FALSE_MESSAGE(reordered.load(), "item lost, duplicated or out of order");
+    TEST_ASSERT_TRUE(queue.IsEmpty());
+}
+
+// one producer and one consumer thread, small and large rings
+void test_two_threads_small()
+{
+    stress<2>();
+}
+
+void test_two_threads_event_queue()
+{
+    stress<8>();
+}
+
+void test_two_threads_large()
+{
+    stress<128>();
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fills_to_capacity);
+    RUN_TEST(test_index_wrap);
+    RUN_TEST(test_two_threads_small);
+    RUN_TEST(test_two_threads_event_queue);
+    RUN_TEST(test_two_threads_large);
+    return UNITY_END();
+}